@@ -10,30 +10,105 @@
 #include <iomanip>
 #include <cmath>
 #include <algorithm>
+#include <sstream>
+#include <cstring>
+#include <memory>
+#include <map>
+#include <deque>
+#include <condition_variable>
+#include <limits>
+#include <unordered_set>
+#include <unordered_map>
+#include <string_view>
+#include <queue>
+#include <cctype>
+#include <array>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netdb.h>
+#include <arpa/inet.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <pthread.h>
+#include <sched.h>
+#include <fcntl.h>
+#include <signal.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include <cerrno>
+#include <zlib.h>
+
+// One step of simpleHash(): fold the next byte into the running state
+inline uint32_t simpleHashStep(uint32_t hash, char c) {
+    return hash * 31 + static_cast<uint32_t>(c);
+}
 
 // Simple hash function - converts password string to a hash value
-uint32_t simpleHash(const std::string& password) {
+uint32_t simpleHash(std::string_view password) {
     uint32_t hash = 0;
     for (char c : password) {
-        hash = hash * 31 + static_cast<uint32_t>(c);
+        hash = simpleHashStep(hash, c);
     }
     return hash;
 }
 
+uint32_t simpleHash(const std::string& password) {
+    return simpleHash(std::string_view(password));
+}
+
 // Global shared state
 struct SearchState {
     uint32_t targetHash;
     std::string foundPassword;
     std::atomic<bool> passwordFound{false};
+    std::atomic<bool> stopRequested{false};  // found, interrupted or told to stop
+    std::atomic<bool> interrupted{false};    // SIGINT/SIGTERM received
     std::atomic<long long> totalAttempts{0};
+    std::atomic<long long> skippedCandidates{0};  // counted in totalAttempts but never hashed
+    std::atomic<long long> filteredCandidates{0}; // of those, rejected by the policy filter
     std::mutex resultMutex;
     std::chrono::steady_clock::time_point startTime;
+    long long keySpaceSize{0};     // candidates this run is responsible for
+    long long rangeStart{0};       // first index of this run's slice
+    long long rangeEnd{0};         // one past the last index
+    long long fullKeySpace{0};     // calculateKeySpace(maxLength)
+    std::string shardLabel;        // "i/n" when --shard is used
+    
+    // Candidates that actually reached the hash function; throughput is
+    // reported from these, so empty --expand slots do not inflate it
+    long long hashedCandidates() const { return totalAttempts.load() - skippedCandidates.load(); }
 } searchState;
 
+// Lock-free per-thread progress counter, padded to its own cache line so
+// readers (e.g. the metrics endpoint) never contend with the workers.
+struct alignas(64) ThreadCounter {
+    std::atomic<long long> attempts{0};
+};
+
+// One counter per worker thread, sized in main() before workers start
+std::unique_ptr<ThreadCounter[]> threadCounters;
+std::atomic<int> threadCounterCount{0};
+
 // Performance metrics
 struct PerformanceMetrics {
+    struct ThreadCountChange {
+        double seconds;        // since the search started
+        int from;
+        int to;
+        std::string reason;
+    };
+    
+    std::vector<int> threadIds;
     std::vector<long long> attemptsPerThread;
     std::vector<double> threadTimes;
+    std::vector<ThreadCountChange> threadTimeline;   // --elastic resizes, in order
     std::mutex logMutex;
     std::mutex outputMutex;
 } perfMetrics;
@@ -41,7 +116,11 @@ struct PerformanceMetrics {
 // Character set for password generation (digits and lowercase letters)
 const std::string CHARSET = "0123456789abcdefghijklmnopqrstuvwxyz";
 
-std::string indexToPassword(long long index, int maxLength) {
+/**
+ * Write candidate `index` into `out`, reusing its storage; `out` is left
+ * empty if the index is past the key space
+ */
+void indexToPasswordInto(long long index, int maxLength, std::string& out) {
     int base = CHARSET.length();
     
     // Find which length tier this index falls into
@@ -56,23 +135,42 @@ std::string indexToPassword(long long index, int maxLength) {
     }
     
     if (len > maxLength) {
-        return ""; // Index out of bounds
+        out.clear(); // Index out of bounds
+        return;
     }
     
     // Get position within this length tier
     long long index_in_tier = index - cumulative;
     
     // Convert to password of length 'len'
-    std::string password(len, CHARSET[0]);
+    out.resize(len);
     
     for (int i = len - 1; i >= 0; i--) {
-        password[i] = CHARSET[index_in_tier % base];
+        out[i] = CHARSET[index_in_tier % base];
         index_in_tier /= base;
     }
-    
+}
+
+std::string indexToPassword(long long index, int maxLength) {
+    std::string password;
+    indexToPasswordInto(index, maxLength, password);
     return password;
 }
 
+/**
+ * Exact bounds of shard `index` (0-based) out of `count` over [0, keySpace)
+ * 
+ * The first keySpace % count shards get one extra index, so consecutive
+ * shards tile the space with no gap and no overlap.
+ */
+std::pair<long long, long long> shardBounds(long long keySpace, int index, int count) {
+    long long base = keySpace / count;
+    long long extra = keySpace % count;
+    long long start = index * base + std::min<long long>(index, extra);
+    long long end = start + base + (index < extra ? 1 : 0);
+    return {start, end};
+}
+
 /**
  * Calculate total key space size for passwords up to maxLength
  * 
@@ -92,255 +190,8283 @@ long long calculateKeySpace(int maxLength) {
     return total;
 }
 
+// a * b, or LLONG_MAX when the product does not fit
+long long saturatingMultiply(long long a, long long b) {
+    if (a != 0 && b > std::numeric_limits<long long>::max() / a) {
+        return std::numeric_limits<long long>::max();
+    }
+    return a * b;
+}
 
-void crackerWorker(int threadId, long long startIndex, long long endIndex, int maxLength) {
-    auto threadStartTime = std::chrono::steady_clock::now();
-    long long attempts = 0;
-    long long localBatchCount = 0;
+/**
+ * Key space of lengths minLength..maxLength over a charsetSize-symbol
+ * alphabet, saturating at LLONG_MAX where the plain version would overflow
+ */
+long long calculateKeySpace(int minLength, int maxLength, long long charsetSize) {
+    long long total = 0;
+    long long power = 1;
+    for (int i = 1; i <= maxLength; i++) {
+        power = saturatingMultiply(power, charsetSize);
+        if (i >= minLength) {
+            total = power > std::numeric_limits<long long>::max() - total
+                ? std::numeric_limits<long long>::max() : total + power;
+        }
+    }
+    return total;
+}
+
+/**
+ * Per-length-tier accounting
+ * 
+ * Workers charge candidates and time to a tier once per slice piece (a
+ * slice is cut at tier boundaries), never per candidate.
+ */
+const int MAX_TIERS = 16;
+
+struct alignas(64) TierCounter {
+    std::atomic<long long> candidates{0};
+    std::atomic<long long> nanos{0};                 // summed thread time
+    std::atomic<unsigned long long> threadMask{0};   // bit i = thread i (63 = 63 and up)
+};
+
+struct TierStats {
+    int tiers = 0;                        // 0 = accounting disabled
+    long long start[MAX_TIERS + 1] = {};  // start[t] = first index of length t+1
+    TierCounter counters[MAX_TIERS];
+} tierStats;
+
+void initTierStats(int maxLength) {
+    long long base = CHARSET.length();
+    long long power = 1;
+    tierStats.tiers = std::min(maxLength, MAX_TIERS);
+    tierStats.start[0] = 0;
+    for (int t = 0; t < tierStats.tiers; ++t) {
+        power *= base;
+        tierStats.start[t + 1] = tierStats.start[t] + power;
+    }
+}
+
+// Tier (0-based: length - 1) containing index, or -1 outside the table
+int tierOfIndex(long long index) {
+    for (int t = 0; t < tierStats.tiers; ++t) {
+        if (index < tierStats.start[t + 1]) {
+            return index >= tierStats.start[t] ? t : -1;
+        }
+    }
+    return -1;
+}
+
+
+/**
+ * Keyed bijective enumeration order
+ * 
+ * When enabled, search position p is mapped to a key-space index through
+ * a 4-round balanced Feistel network over the smallest even number of bits
+ * that covers the space, cycle-walking until the result falls inside it.
+ * Ranges, shards and restore points keep working on positions, while any
+ * prefix of the run is a uniform sample of the whole space.
+ */
+struct EnumerationOrder {
+    bool permuted = false;
+    uint64_t seed = 0;
+    long long spaceStart = 0;   // first index of the permuted space
+    uint64_t size = 0;          // indices in the permuted space
+    int halfBits = 0;
+    uint64_t halfMask = 0;
+    uint64_t keys[4] = {};
     
-    {
-        std::lock_guard<std::mutex> lock(perfMetrics.outputMutex);
-        std::cout << "[Thread " << threadId << "] Starting search from index " 
-                  << startIndex << " to " << endIndex << std::endl;
+    static uint64_t mix(uint64_t x) {
+        // splitmix64 finaliser
+        x += 0x9e3779b97f4a7c15ULL;
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+        return x ^ (x >> 31);
     }
     
-    // Search through assigned portion of key space
-    for (long long i = startIndex; i < endIndex && !searchState.passwordFound.load(); ++i) {
-        // Generate password candidate
-        std::string candidate = indexToPassword(i, maxLength);
-        
-        if (candidate.empty()) {
-            break; // Out of valid range
-        }
-        
-        // Compute hash
-        uint32_t hash = simpleHash(candidate);
-        attempts++;
-        localBatchCount++;
-        
-        // Check if hash matches target
-        if (hash == searchState.targetHash) {
-            // Found the password!
-            std::lock_guard<std::mutex> lock(searchState.resultMutex);
-            
-            if (!searchState.passwordFound.load()) {
-                searchState.passwordFound.store(true);
-                searchState.foundPassword = candidate;
-                searchState.totalAttempts.fetch_add(localBatchCount);
-                localBatchCount = 0;
-                
-                {
-                    std::lock_guard<std::mutex> outputLock(perfMetrics.outputMutex);
-                    std::cout << "\n[Thread " << threadId << "] FOUND PASSWORD: \"" 
-                              << candidate << "\" (after " << attempts << " attempts)" << std::endl;
-                }
-            }
-            break;
+    void setup(long long start, long long count, uint64_t key) {
+        permuted = true;
+        seed = key;
+        spaceStart = start;
+        size = static_cast<uint64_t>(count);
+        int bits = 2;
+        while (bits < 62 && (1ULL << bits) < size) {
+            bits += 2;
         }
-        
-        // Periodic progress update (every 50000 attempts)
-        if (localBatchCount >= 50000) {
-            searchState.totalAttempts.fetch_add(localBatchCount);
-            localBatchCount = 0;
+        halfBits = bits / 2;
+        halfMask = (1ULL << halfBits) - 1;
+        for (int r = 0; r < 4; ++r) {
+            keys[r] = mix(seed + 0x632be59bd9b4e019ULL * (r + 1));
         }
     }
     
-    // Final attempt count update
-    if (localBatchCount > 0) {
-        searchState.totalAttempts.fetch_add(localBatchCount);
+    uint64_t feistel(uint64_t x) const {
+        uint64_t left = x >> halfBits;
+        uint64_t right = x & halfMask;
+        for (int r = 0; r < 4; ++r) {
+            uint64_t next = left ^ (mix(right ^ keys[r]) & halfMask);
+            left = right;
+            right = next;
+        }
+        return (left << halfBits) | right;
     }
     
-    auto threadEndTime = std::chrono::steady_clock::now();
-    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
-        threadEndTime - threadStartTime).count();
-    
-    // Record performance metrics
-    {
-        std::lock_guard<std::mutex> lock(perfMetrics.logMutex);
-        perfMetrics.attemptsPerThread.push_back(attempts);
-        perfMetrics.threadTimes.push_back(duration / 1000.0);
+    long long map(long long position) const {
+        uint64_t x = static_cast<uint64_t>(position - spaceStart);
+        do {
+            x = feistel(x);
+        } while (x >= size);
+        return spaceStart + static_cast<long long>(x);
     }
-    
-    {
-        std::lock_guard<std::mutex> lock(perfMetrics.outputMutex);
-        std::cout << "[Thread " << threadId << "] Completed. Attempted " 
-                  << attempts << " passwords in " 
-                  << std::fixed << std::setprecision(2) << (duration / 1000.0) 
-                  << " seconds" << std::endl;
+} enumerationOrder;
+
+// Where candidates come from; PCFG guesses are not index-addressable and
+// use their own worker loop (see runPcfgSearch())
+enum class CandidateSource { BruteForce, Prince, Pcfg, Keyboard, Dates, Masks, Wordlist, Compiled, Stream, Stdin };
+
+CandidateSource candidateSource = CandidateSource::BruteForce;
+
+const char* candidateSourceName() {
+    switch (candidateSource) {
+        case CandidateSource::Prince: return "prince";
+        case CandidateSource::Pcfg: return "pcfg";
+        case CandidateSource::Keyboard: return "keyboard";
+        case CandidateSource::Dates: return "dates";
+        case CandidateSource::Masks: return "masks";
+        case CandidateSource::Wordlist: return "wordlist";
+        case CandidateSource::Compiled: return "compiled-wordlist";
+        case CandidateSource::Stream: return "compressed-wordlist";
+        case CandidateSource::Stdin: return "stdin";
+        default: return "brute-force";
     }
 }
 
 /**
- * Performance logging function
+ * PRINCE-style word chaining
  * 
- * Writes performance metrics to a log file for analysis.
+ * Candidates are chains of one or more elements (wordlist entries) whose
+ * total length falls in the requested range. The chain space is indexed
+ * like the brute-force key space: chains are ordered by output length,
+ * then by element count, then by element length and wordlist position, so
+ * an index decodes directly to a chain and ranges, shards, tier counters
+ * and restore points work unchanged.
+ * 
+ * Elements live in one contiguous arena grouped by length (all length-1
+ * elements, then all length-2 elements, ...), so decoding is a few
+ * divisions plus memcpy into the caller's buffer, with no allocation.
  */
-void logPerformanceMetrics() {
-    std::ofstream logFile("performance_log.txt");
-    if (!logFile.is_open()) {
-        std::cerr << "Warning: Could not open performance_log.txt for writing.\n";
-        return;
-    }
-    
-    auto endTime = std::chrono::steady_clock::now();
-    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
-        endTime - searchState.startTime).count();
-    
-    logFile << "═══════════════════════════════════════════════════\n";
-    logFile << "  PASSWORD CRACKER PERFORMANCE REPORT\n";
-    logFile << "═══════════════════════════════════════════════════\n\n";
-    
-    logFile << "Total Search Duration: " << std::fixed << std::setprecision(3) 
-            << (duration / 1000.0) << " seconds\n\n";
-    
-    logFile << "Throughput Metrics:\n";
-    logFile << "  Total Attempts: " << searchState.totalAttempts.load() << "\n";
+struct PrinceChains {
+    std::string wordlist;
+    int maxLength = 0;
+    int maxElements = 0;
+    long long elementCount = 0;
+    std::vector<char> arena;
+    std::vector<long long> offset;       // offset[l] = arena position of the length-l group
+    std::vector<long long> count;        // count[l] = elements of length l
+    std::vector<long long> chains;       // chains[len * (maxElements + 1) + e]
+    std::vector<long long> lengthStart;  // first index of each output length (size maxLength + 2)
+    long long total = 0;
     
-    if (duration > 0) {
-        logFile << "  Attempts per Second: " << std::fixed << std::setprecision(2)
-                << (searchState.totalAttempts.load() * 1000.0 / duration) 
-                << " attempts/sec\n\n";
-    } else {
-        logFile << "  Attempts per Second: N/A (duration too short)\n\n";
+    long long& chainsOf(int length, int elements) {
+        return chains[length * (maxElements + 1) + elements];
+    }
+    long long chainsOf(int length, int elements) const {
+        return chains[length * (maxElements + 1) + elements];
     }
     
-    logFile << "Thread Performance:\n";
-    for (size_t i = 0; i < perfMetrics.attemptsPerThread.size(); ++i) {
-        logFile << "  Thread " << i << ":\n";
-        logFile << "    Attempts: " << perfMetrics.attemptsPerThread[i] << "\n";
-        logFile << "    Time: " << std::fixed << std::setprecision(2) 
-                << perfMetrics.threadTimes[i] << " seconds\n";
+    /**
+     * Load elements from `path` and size the chain space; false (with a
+     * message in `error`) if the file cannot be read or the space does not
+     * fit in a 64-bit index
+     */
+    bool load(const std::string& path, int maxLen, int maxElems, std::string& error) {
+        std::ifstream file(path);
+        if (!file.is_open()) {
+            error = "could not open " + path;
+            return false;
+        }
+        wordlist = path;
+        maxLength = maxLen;
+        maxElements = maxElems;
         
-        if (perfMetrics.threadTimes[i] > 0) {
-            logFile << "    Speed: " << std::fixed << std::setprecision(2)
-                    << (perfMetrics.attemptsPerThread[i] / perfMetrics.threadTimes[i])
-                    << " attempts/sec\n";
+        // Group by length, keeping wordlist order and dropping repeats
+        std::vector<std::vector<std::string>> byLength(maxLength + 1);
+        std::unordered_set<std::string> seen;
+        std::string line;
+        while (std::getline(file, line)) {
+            if (!line.empty() && line.back() == '\r') {
+                line.pop_back();
+            }
+            if (!line.empty() && static_cast<int>(line.size()) <= maxLength && seen.insert(line).second) {
+                byLength[line.size()].push_back(line);
+            }
         }
-        logFile << "\n";
+        
+        offset.assign(maxLength + 1, 0);
+        count.assign(maxLength + 1, 0);
+        arena.clear();
+        elementCount = 0;
+        for (int l = 1; l <= maxLength; ++l) {
+            offset[l] = static_cast<long long>(arena.size());
+            count[l] = static_cast<long long>(byLength[l].size());
+            elementCount += count[l];
+            for (const auto& element : byLength[l]) {
+                arena.insert(arena.end(), element.begin(), element.end());
+            }
+        }
+        if (elementCount == 0) {
+            error = "no usable elements (1 to " + std::to_string(maxLength) + " characters) in " + path;
+            return false;
+        }
+        
+        // chains(len, e) = sum over first-element length l of count[l] * chains(len - l, e - 1)
+        const long long limit = std::numeric_limits<long long>::max();
+        chains.assign((maxLength + 1) * (maxElements + 1), 0);
+        chainsOf(0, 0) = 1;
+        for (int len = 1; len <= maxLength; ++len) {
+            for (int e = 1; e <= maxElements; ++e) {
+                long long sum = 0;
+                for (int l = 1; l <= len; ++l) {
+                    long long product = 0;
+                    if (__builtin_mul_overflow(count[l], chainsOf(len - l, e - 1), &product) ||
+                        __builtin_add_overflow(sum, product, &sum)) {
+                        sum = limit;
+                        break;
+                    }
+                }
+                chainsOf(len, e) = sum;
+            }
+        }
+        
+        lengthStart.assign(maxLength + 2, 0);
+        for (int len = 1; len <= maxLength; ++len) {
+            long long tier = 0;
+            for (int e = 1; e <= maxElements; ++e) {
+                if (chainsOf(len, e) == limit || __builtin_add_overflow(tier, chainsOf(len, e), &tier) ||
+                    __builtin_add_overflow(lengthStart[len], tier, &lengthStart[len + 1])) {
+                    error = "chain space exceeds a 64-bit index; lower --max-length or --prince-elements";
+                    return false;
+                }
+            }
+        }
+        total = lengthStart[maxLength + 1];
+        return true;
     }
     
-    logFile << "═══════════════════════════════════════════════════\n";
-    logFile.close();
-}
+    /**
+     * Write the chain at `index` (0 <= index < total) into `out`
+     */
+    void decode(long long index, std::string& out) const {
+        int remaining = 1;
+        while (index >= lengthStart[remaining + 1]) {
+            remaining++;
+        }
+        index -= lengthStart[remaining];
+        
+        int elements = 1;
+        while (index >= chainsOf(remaining, elements)) {
+            index -= chainsOf(remaining, elements);
+            elements++;
+        }
+        
+        out.resize(remaining);
+        char* cursor = &out[0];
+        for (; elements > 0; --elements) {
+            for (int l = 1; l <= remaining; ++l) {
+                long long rest = chainsOf(remaining - l, elements - 1);
+                long long block = count[l] * rest;   // cannot overflow: bounded by chainsOf(remaining, elements)
+                if (index < block) {
+                    long long element = index / rest;
+                    index %= rest;
+                    std::memcpy(cursor, &arena[offset[l] + element * l], l);
+                    cursor += l;
+                    remaining -= l;
+                    break;
+                }
+                index -= block;
+            }
+        }
+    }
+} princeChains;
 
-int main(int argc, char* argv[]) {
-    // Configuration
-    std::string targetPassword = "test";
-    int numThreads = 4;
-    int maxLength = 4;
+/**
+ * Keyboard walks
+ * 
+ * A walk starts on any key and moves to a neighbouring key in one of
+ * eight grid directions (or repeats the key) at each step, as in "qwerty",
+ * "1qaz" or "1111". At most `maxTurns` direction changes are allowed, plus
+ * `maxJumps` jumps to a non-adjacent key, which start a fresh walk
+ * ("qwerty" + "123"). Because a jump never lands on a key a step could
+ * reach, every string has exactly one parse and the space has no
+ * duplicates.
+ * 
+ * walksFrom(steps, key, last, turns, jumps) counts the continuations of
+ * exactly `steps` more keys; walks are ordered by length, then start key,
+ * then step (directions first, jumps last), so an index decodes by
+ * subtracting those counts.
+ */
+const int KB_DIRECTIONS = 9;   // E, W, S, N, SE, NW, SW, NE, repeat
+const int KB_NONE = KB_DIRECTIONS;
+const int KB_ROW_STEP[KB_DIRECTIONS] = {0, 0, 1, -1, 1, -1, 1, -1, 0};
+const int KB_COL_STEP[KB_DIRECTIONS] = {1, -1, 0, 0, 1, -1, -1, 1, 0};
+
+// Unshifted US QWERTY; spaces in a layout file are holes
+const std::vector<std::string> QWERTY_ROWS = {
+    "1234567890-=", "qwertyuiop[]", "asdfghjkl;'", "zxcvbnm,./"
+};
+
+struct KeyboardWalks {
+    int maxLength = 0;
+    int maxTurns = 0;
+    int maxJumps = 0;
+    std::string keys;                        // key index -> character
+    std::vector<std::vector<int>> neighbour; // [key][direction], -1 off the layout
+    std::vector<long long> walks;            // see index()
+    std::vector<long long> startTotal;       // [steps][turns][jumps] summed over start keys
+    std::vector<long long> lengthStart;
+    long long total = 0;
     
-    // Parse command line arguments
-    if (argc >= 2) {
-        targetPassword = argv[1];
+    size_t index(int steps, int key, int last, int turns, int jumps) const {
+        return (((static_cast<size_t>(steps) * keys.size() + key) * (KB_DIRECTIONS + 1) + last)
+                * (maxTurns + 1) + turns) * (maxJumps + 1) + jumps;
     }
-    if (argc >= 3) {
-        numThreads = std::stoi(argv[2]);
-        if (numThreads < 1) numThreads = 1;
+    long long walksFrom(int steps, int key, int last, int turns, int jumps) const {
+        return walks[index(steps, key, last, turns, jumps)];
     }
-    if (argc >= 4) {
-        maxLength = std::stoi(argv[3]);
-        if (maxLength < 1) maxLength = 1;
-        if (maxLength > 8) {
-            std::cout << "Warning: maxLength > 8 may take very long. Limiting to 8.\n";
-            maxLength = 8;
-        }
+    long long anyStart(int steps, int turns, int jumps) const {
+        return startTotal[(static_cast<size_t>(steps) * (maxTurns + 1) + turns) * (maxJumps + 1) + jumps];
     }
     
-    // Calculate target hash
-    searchState.targetHash = simpleHash(targetPassword);
-    
-    std::cout << "═══════════════════════════════════════════════════\n";
-    std::cout << "  MULTITHREADED PASSWORD CRACKER\n";
-    std::cout << "═══════════════════════════════════════════════════\n";
-    std::cout << "Target Password: \"" << targetPassword << "\"\n";
-    std::cout << "Target Hash: " << searchState.targetHash << "\n";
-    std::cout << "Number of Threads: " << numThreads << "\n";
-    std::cout << "Maximum Password Length: " << maxLength << "\n";
-    std::cout << "Character Set: " << CHARSET << " (" << CHARSET.length() 
-              << " characters)\n";
-    std::cout << "═══════════════════════════════════════════════════\n\n";
-    
-    // Calculate key space size
-    long long keySpaceSize = calculateKeySpace(maxLength);
-    
-    std::cout << "Key Space Size: " << keySpaceSize << " possible passwords\n";
-    std::cout << "  (All passwords from length 1 to " << maxLength << ")\n\n";
-    
-    // Partition key space among threads
-    long long rangePerThread = keySpaceSize / numThreads;
-    long long remainder = keySpaceSize % numThreads;
-    
-    std::cout << "Key Space Partitioning:\n";
-    for (int i = 0; i < numThreads; ++i) {
-        long long start = i * rangePerThread;
-        long long end = (i + 1) * rangePerThread;
-        if (i == numThreads - 1) {
-            end += remainder;
+    // Keys a jump from `key` may land on: anything a step cannot reach
+    bool jumpAllowed(int key, int target) const {
+        for (int d = 0; d < KB_DIRECTIONS; ++d) {
+            if (neighbour[key][d] == target) {
+                return false;
+            }
         }
-        std::cout << "  Thread " << i << ": indices " << start << " to " << end 
-                  << " (" << (end - start) << " passwords)\n";
+        return true;
     }
-    std::cout << "\n";
-    
-    searchState.startTime = std::chrono::steady_clock::now();
     
-    // Start worker threads
-    std::vector<std::thread> threads;
-    for (int i = 0; i < numThreads; ++i) {
-        long long start = i * rangePerThread;
-        long long end = (i + 1) * rangePerThread;
-        if (i == numThreads - 1) {
-            end += remainder;
+    /**
+     * Build the layout graph from `rows` and count the walk space; false
+     * (with a message in `error`) on a bad layout or a space that does not
+     * fit in a 64-bit index
+     */
+    bool setup(const std::vector<std::string>& rows, int maxLen, int turns, int jumps,
+               std::string& error) {
+        maxLength = maxLen;
+        maxTurns = turns;
+        maxJumps = jumps;
+        keys.clear();
+        std::map<std::pair<int, int>, int> position;
+        for (size_t r = 0; r < rows.size(); ++r) {
+            for (size_t c = 0; c < rows[r].size(); ++c) {
+                char key = rows[r][c];
+                if (key == ' ' || key == '\t' || key == '\r') {
+                    continue;
+                }
+                if (keys.find(key) != std::string::npos) {
+                    error = std::string("key '") + key + "' appears twice in the layout";
+                    return false;
+                }
+                position[{static_cast<int>(r), static_cast<int>(c)}] = static_cast<int>(keys.size());
+                keys.push_back(key);
+            }
+        }
+        if (keys.empty()) {
+            error = "the layout has no keys";
+            return false;
+        }
+        neighbour.assign(keys.size(), std::vector<int>(KB_DIRECTIONS, -1));
+        for (const auto& entry : position) {
+            for (int d = 0; d < KB_DIRECTIONS; ++d) {
+                auto next = position.find({entry.first.first + KB_ROW_STEP[d],
+                                           entry.first.second + KB_COL_STEP[d]});
+                if (next != position.end()) {
+                    neighbour[entry.second][d] = next->second;
+                }
+            }
         }
         
-        threads.emplace_back(crackerWorker, i, start, end, maxLength);
-    }
-    
-    // Wait for all threads to complete
-    for (auto& t : threads) {
-        if (t.joinable()) {
-            t.join();
+        const long long limit = std::numeric_limits<long long>::max();
+        auto add = [&](long long& sum, long long value) {
+            if (__builtin_add_overflow(sum, value, &sum)) {
+                sum = limit;
+            }
+        };
+        int keyCount = static_cast<int>(keys.size());
+        walks.assign(index(maxLength, 0, 0, 0, 0), 0);
+        startTotal.assign(static_cast<size_t>(maxLength) * (maxTurns + 1) * (maxJumps + 1), 0);
+        for (int s = 0; s < maxLength; ++s) {
+            for (int k = 0; k < keyCount; ++k) {
+                for (int last = 0; last <= KB_DIRECTIONS; ++last) {
+                    for (int t = 0; t <= maxTurns; ++t) {
+                        for (int j = 0; j <= maxJumps; ++j) {
+                            long long count = s == 0 ? 1 : 0;
+                            for (int d = 0; d < KB_DIRECTIONS && s > 0; ++d) {
+                                int next = neighbour[k][d];
+                                bool turn = last != KB_NONE && d != last;
+                                if (next >= 0 && (!turn || t > 0)) {
+                                    add(count, walksFrom(s - 1, next, d, t - (turn ? 1 : 0), j));
+                                }
+                            }
+                            if (s > 0 && j > 0) {
+                                for (int target = 0; target < keyCount; ++target) {
+                                    if (jumpAllowed(k, target)) {
+                                        add(count, walksFrom(s - 1, target, KB_NONE, t, j - 1));
+                                    }
+                                }
+                            }
+                            walks[index(s, k, last, t, j)] = count;
+                            if (last == KB_NONE) {
+                                add(startTotal[(static_cast<size_t>(s) * (maxTurns + 1) + t) *
+                                              (maxJumps + 1) + j], count);
+                            }
+                        }
+                    }
+                }
+            }
         }
+        
+        lengthStart.assign(maxLength + 2, 0);
+        for (int len = 1; len <= maxLength; ++len) {
+            long long tier = anyStart(len - 1, maxTurns, maxJumps);
+            if (tier == limit || __builtin_add_overflow(lengthStart[len], tier, &lengthStart[len + 1])) {
+                error = "walk space exceeds a 64-bit index; lower --max-length or --kb-jumps";
+                return false;
+            }
+        }
+        total = lengthStart[maxLength + 1];
+        return true;
     }
     
-    auto endTime = std::chrono::steady_clock::now();
-    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
-        endTime - searchState.startTime).count();
-    
-    // Display results
-    std::cout << "\n═══════════════════════════════════════════════════\n";
-    std::cout << "  RESULTS\n";
-    std::cout << "═══════════════════════════════════════════════════\n";
-    
-    if (searchState.passwordFound.load()) {
-        std::cout << "✓ Password FOUND: \"" << searchState.foundPassword << "\"\n";
-        std::cout << "  Expected: \"" << targetPassword << "\"\n";
+    /**
+     * Write the walk at `index` (0 <= index < total) into `out`
+     */
+    void decode(long long index, std::string& out) const {
+        int length = 1;
+        while (index >= lengthStart[length + 1]) {
+            length++;
+        }
+        index -= lengthStart[length];
+        out.resize(length);
         
-        if (searchState.foundPassword == targetPassword) {
-            std::cout << "  Status: EXACT MATCH ✓\n";
-        } else {
-            std::cout << "  Status: Hash collision (different password, same hash)\n";
+        int steps = length - 1;
+        int key = 0;
+        while (index >= walksFrom(steps, key, KB_NONE, maxTurns, maxJumps)) {
+            index -= walksFrom(steps, key, KB_NONE, maxTurns, maxJumps);
+            key++;
+        }
+        int last = KB_NONE, turns = maxTurns, jumps = maxJumps;
+        out[0] = keys[key];
+        for (int i = 1; i <= length - 1; ++i) {
+            steps--;
+            bool stepped = false;
+            for (int d = 0; d < KB_DIRECTIONS && !stepped; ++d) {
+                int next = neighbour[key][d];
+                bool turn = last != KB_NONE && d != last;
+                if (next < 0 || (turn && turns == 0)) {
+                    continue;
+                }
+                long long block = walksFrom(steps, next, d, turns - (turn ? 1 : 0), jumps);
+                if (index < block) {
+                    turns -= turn ? 1 : 0;
+                    key = next;
+                    last = d;
+                    stepped = true;
+                } else {
+                    index -= block;
+                }
+            }
+            for (int target = 0; !stepped; ++target) {
+                if (!jumpAllowed(key, target)) {
+                    continue;
+                }
+                long long block = walksFrom(steps, target, KB_NONE, turns, jumps - 1);
+                if (index < block) {
+                    key = target;
+                    last = KB_NONE;
+                    jumps--;
+                    stepped = true;
+                } else {
+                    index -= block;
+                }
+            }
+            out[i] = keys[key];
         }
-    } else {
-        std::cout << "✗ Password NOT FOUND in searched key space\n";
-        std::cout << "  (Password may be longer than maxLength=" << maxLength << ")\n";
     }
+} keyboardWalks;
+
+/**
+ * Date patterns
+ * 
+ * Every calendar day, month or year in [firstYear, lastYear] rendered in
+ * a list of common formats ("19840512", "12.05.1984", "0584", "1984"),
+ * with each separator for multi-field formats. Each (format, separator)
+ * pair is a block of days, months or years; blocks are ordered by output
+ * length, so the space splits into length tiers like the others. Blocks
+ * with a two-digit year draw from lists holding each YY value once, so a
+ * range spanning centuries (1925 and 2025) does not repeat "250512".
+ * 
+ * Digit runs, repeats and sequences ("123456", "111111", "987654") are not
+ * generated here: they are walks along the number row and already come
+ * out of --keyboard.
+ */
+struct DatePatterns {
+    struct Block {
+        std::vector<std::string> fields;   // "YYYY", "YY", "MM", "DD"
+        char separator = 0;                // 0 = none
+        int length = 0;
+        char unit = 'D';                   // iterates days, months or years
+        bool needsYear = true;             // false: day-of-year formats (DDMM)
+        bool shortYear = false;            // YY: one entry per two-digit year
+        long long start = 0;               // first index of the block
+        long long size = 0;
+    };
+    struct Date {
+        int year, month, day;
+    };
     
-    std::cout << "\nPerformance Summary:\n";
-    std::cout << "  Total Attempts: " << searchState.totalAttempts.load() << "\n";
-    std::cout << "  Total Time: " << std::fixed << std::setprecision(3) 
-              << (duration / 1000.0) << " seconds\n";
+    int firstYear = 0;
+    int lastYear = 0;
+    int maxLength = 0;
+    std::vector<Date> days, months, years, daysOfYear;
+    std::vector<Date> shortDays, shortMonths, shortYears;   // unique per year % 100
+    std::vector<Block> blocks;
+    std::vector<long long> lengthStart;
+    long long total = 0;
     
-    if (duration > 0) {
-        std::cout << "  Throughput: " << std::fixed << std::setprecision(2)
-                  << (searchState.totalAttempts.load() * 1000.0 / duration) 
-                  << " attempts/sec\n";
+    static bool leap(int year) {
+        return (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
     }
     
-    // Log performance metrics
-    logPerformanceMetrics();
+    void setup(int first, int last, int maxLen) {
+        firstYear = first;
+        lastYear = last;
+        maxLength = maxLen;
+        static const int monthDays[12] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+        days.clear();
+        months.clear();
+        years.clear();
+        daysOfYear.clear();
+        shortDays.clear();
+        shortMonths.clear();
+        shortYears.clear();
+        auto addYear = [&](int y, std::vector<Date>& yearList, std::vector<Date>& monthList,
+                           std::vector<Date>& dayList) {
+            yearList.push_back({y, 1, 1});
+            for (int m = 1; m <= 12; ++m) {
+                monthList.push_back({y, m, 1});
+                int count = monthDays[m - 1] + (m == 2 && leap(y) ? 1 : 0);
+                for (int d = 1; d <= count; ++d) {
+                    dayList.push_back({y, m, d});
+                }
+            }
+        };
+        // Each YY stands for the first year in the range with those digits,
+        // or a leap year among them so that 29.02 is still produced
+        int representative[100];
+        std::fill(representative, representative + 100, -1);
+        for (int y = firstYear; y <= lastYear; ++y) {
+            addYear(y, years, months, days);
+            int& chosen = representative[y % 100];
+            if (chosen < 0 || (leap(y) && !leap(chosen))) {
+                chosen = y;
+            }
+        }
+        for (int y = firstYear; y <= lastYear && y < firstYear + 100; ++y) {
+            addYear(representative[y % 100], shortYears, shortMonths, shortDays);
+        }
+        for (int m = 1; m <= 12; ++m) {
+            for (int d = 1; d <= monthDays[m - 1] + (m == 2 ? 1 : 0); ++d) {
+                daysOfYear.push_back({2000, m, d});
+            }
+        }
+        
+        static const std::vector<std::vector<std::string>> formats = {
+            {"YYYY", "MM", "DD"}, {"DD", "MM", "YYYY"}, {"MM", "DD", "YYYY"},
+            {"YY", "MM", "DD"}, {"DD", "MM", "YY"}, {"MM", "DD", "YY"},
+            {"DD", "MM"}, {"MM", "DD"},
+            {"MM", "YYYY"}, {"YYYY", "MM"}, {"MM", "YY"},
+            {"YYYY"}, {"YY"},
+        };
+        static const char separators[] = {0, '.', '-', '/'};
+        blocks.clear();
+        for (const auto& fields : formats) {
+            for (char separator : separators) {
+                if (separator != 0 && fields.size() == 1) {
+                    continue;
+                }
+                Block block;
+                block.fields = fields;
+                block.separator = separator;
+                bool hasDay = false, hasMonth = false;
+                block.needsYear = false;
+                for (const auto& field : fields) {
+                    block.length += static_cast<int>(field.size());
+                    hasDay |= field == "DD";
+                    hasMonth |= field == "MM";
+                    block.needsYear |= field[0] == 'Y';
+                    block.shortYear |= field == "YY";
+                }
+                block.length += separator != 0 ? static_cast<int>(fields.size()) - 1 : 0;
+                block.unit = hasDay ? 'D' : hasMonth ? 'M' : 'Y';
+                if (block.length <= maxLength) {
+                    blocks.push_back(block);
+                }
+            }
+        }
+        std::stable_sort(blocks.begin(), blocks.end(),
+                         [](const Block& a, const Block& b) { return a.length < b.length; });
+        
+        lengthStart.assign(maxLength + 2, 0);
+        long long next = 0;
+        size_t b = 0;
+        for (int len = 1; len <= maxLength; ++len) {
+            lengthStart[len] = next;
+            for (; b < blocks.size() && blocks[b].length == len; ++b) {
+                blocks[b].start = next;
+                blocks[b].size = static_cast<long long>(unitList(blocks[b]).size());
+                next += blocks[b].size;
+            }
+        }
+        lengthStart[maxLength + 1] = next;
+        total = next;
+    }
+    
+    const std::vector<Date>& unitList(const Block& block) const {
+        if (!block.needsYear) {
+            return daysOfYear;
+        }
+        if (block.shortYear) {
+            return block.unit == 'D' ? shortDays : block.unit == 'M' ? shortMonths : shortYears;
+        }
+        return block.unit == 'D' ? days : block.unit == 'M' ? months : years;
+    }
+    
+    /**
+     * Write the date at `index` (0 <= index < total) into `out`
+     */
+    void decode(long long index, std::string& out) const {
+        size_t b = 0;
+        while (index >= blocks[b].start + blocks[b].size) {
+            b++;
+        }
+        const Block& block = blocks[b];
+        const Date& date = unitList(block)[index - block.start];
+        out.resize(block.length);
+        char* cursor = &out[0];
+        for (size_t f = 0; f < block.fields.size(); ++f) {
+            if (f > 0 && block.separator != 0) {
+                *cursor++ = block.separator;
+            }
+            const std::string& field = block.fields[f];
+            int value = field == "DD" ? date.day : field == "MM" ? date.month : date.year;
+            for (int digit = static_cast<int>(field.size()) - 1; digit >= 0; --digit) {
+                cursor[digit] = static_cast<char>('0' + value % 10);
+                value /= 10;
+            }
+            cursor += field.size();
+        }
+    }
+} datePatterns;
+
+/**
+ * Case and leet expansion
+ * 
+ * Every base candidate stands for `stride` consecutive indices: variant v
+ * of a word is v written in mixed radix over the word's first
+ * `maxPositions` mutable characters, where each digit picks the character
+ * as is, with its case toggled, or as its leet substitute. A character
+ * only gets the options that change it, so each distinct variant has
+ * exactly one v and the duplicates a separate case pass and leet pass
+ * would produce ("E" and "e" both becoming "3") never arise. Values of v
+ * past a word's own variant count are skipped without hashing.
+ */
+struct CaseLeetExpansion {
+    bool enabled = false;
+    bool toggleCase = false;
+    bool leet = false;
+    int maxPositions = 8;
+    long long stride = 1;      // indices per base candidate
+    
+    static char leetOf(char c) {
+        switch (std::tolower(static_cast<unsigned char>(c))) {
+            case 'a': return '4';
+            case 'b': return '8';
+            case 'e': return '3';
+            case 'g': return '9';
+            case 'i': return '1';
+            case 'l': return '1';
+            case 'o': return '0';
+            case 's': return '5';
+            case 't': return '7';
+            case 'z': return '2';
+            default: return 0;
+        }
+    }
+    
+    // No base word varies in more positions than its length, so the stride
+    // only needs to cover the longest word the source produces
+    void setup(bool cases, bool substitutions, int positions, int longest) {
+        enabled = cases || substitutions;
+        toggleCase = cases;
+        leet = substitutions;
+        maxPositions = std::min(positions, std::max(1, longest));
+        stride = 1;
+        for (int p = 0; p < maxPositions && enabled; ++p) {
+            stride *= 1 + (toggleCase ? 1 : 0) + (leet ? 1 : 0);
+        }
+    }
+    
+    // Options of one character: itself, then toggled case, then leet
+    int optionsOf(char c) const {
+        return 1 + (toggleCase && std::isalpha(static_cast<unsigned char>(c)) ? 1 : 0) +
+               (leet && leetOf(c) ? 1 : 0);
+    }
+    
+    // Distinct variants of `word`, the word itself included
+    long long variantCount(const std::string& word) const {
+        long long count = 1;
+        int positions = 0;
+        for (size_t i = 0; i < word.size() && positions < maxPositions; ++i) {
+            int options = optionsOf(word[i]);
+            if (options > 1) {
+                count *= options;
+                positions++;
+            }
+        }
+        return count;
+    }
+    
+    /**
+     * Turn `word` into its variant `variant` in place
+     * 
+     * @return false if the word has fewer variants than that (skip it)
+     */
+    bool apply(long long variant, std::string& word) const {
+        for (size_t i = 0; i < word.size() && variant > 0; ++i) {
+            unsigned char c = static_cast<unsigned char>(word[i]);
+            char options[3];
+            int count = 0;
+            options[count++] = word[i];
+            if (toggleCase && std::isalpha(c)) {
+                options[count++] = std::islower(c) ? std::toupper(c) : std::tolower(c);
+            }
+            if (leet && leetOf(word[i])) {
+                options[count++] = leetOf(word[i]);
+            }
+            if (count > 1) {
+                word[i] = options[variant % count];
+                variant /= count;
+            }
+        }
+        return variant == 0;
+    }
+} caseLeet;
+
+/**
+ * Hashcat-style masks
+ * 
+ * Each position is a built-in charset (?l ?u ?d ?s ?a, ?? for a literal
+ * '?') or a literal character. Candidate `index` is a mixed-radix number
+ * over the positions with the last one varying fastest, so a mask is
+ * index-addressable like the other sources and its key space is the
+ * product of its charset sizes.
+ */
+const std::string MASK_LOWER = "abcdefghijklmnopqrstuvwxyz";
+const std::string MASK_UPPER = "ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+const std::string MASK_DIGITS = "0123456789";
+const std::string MASK_SPECIAL = " !\"#$%&'()*+,-./:;<=>?@[\\]^_`{|}~";
+
+struct Mask {
+    std::string text;
+    std::vector<std::string> positions;
+    
+    // Candidates this mask generates, LLONG_MAX if that overflows
+    long long keySpace() const {
+        long long total = 1;
+        for (const auto& charset : positions) {
+            total = saturatingMultiply(total, static_cast<long long>(charset.size()));
+        }
+        return total;
+    }
+    
+    void decode(long long index, std::string& out) const {
+        out.resize(positions.size());
+        for (size_t p = positions.size(); p-- > 0;) {
+            long long size = static_cast<long long>(positions[p].size());
+            out[p] = positions[p][index % size];
+            index /= size;
+        }
+    }
+    
+    // Whether `candidate` is one of this mask's candidates
+    bool matches(const char* candidate, size_t length) const {
+        if (length != positions.size()) {
+            return false;
+        }
+        for (size_t p = 0; p < length; ++p) {
+            if (positions[p].find(candidate[p]) == std::string::npos) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+/**
+ * Parse a mask such as "?u?l?l?l?d?d" or "Summer?d?d"
+ * 
+ * @return false on an unknown "?x" or a trailing '?'
+ */
+bool parseMask(const std::string& text, Mask& mask) {
+    mask.text = text;
+    mask.positions.clear();
+    for (size_t i = 0; i < text.size(); ++i) {
+        if (text[i] != '?') {
+            mask.positions.push_back(std::string(1, text[i]));
+            continue;
+        }
+        if (++i == text.size()) {
+            return false;
+        }
+        switch (text[i]) {
+            case 'l': mask.positions.push_back(MASK_LOWER); break;
+            case 'u': mask.positions.push_back(MASK_UPPER); break;
+            case 'd': mask.positions.push_back(MASK_DIGITS); break;
+            case 's': mask.positions.push_back(MASK_SPECIAL); break;
+            case 'a': mask.positions.push_back(MASK_LOWER + MASK_UPPER + MASK_DIGITS + MASK_SPECIAL); break;
+            case '?': mask.positions.push_back("?"); break;
+            default: return false;
+        }
+    }
+    return !mask.positions.empty();
+}
+
+/**
+ * Stream a newline-separated wordlist in large read(2) blocks, calling
+ * visit(word, length) for every non-empty line with any '\r' stripped.
+ * visit returns false to stop early.
+ * 
+ * @return false if the file cannot be opened or read
+ */
+template <typename Visit>
+bool forEachWord(const std::string& path, Visit visit) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    std::vector<char> buffer(1 << 20);
+    std::string carry;   // a line split across two blocks
+    bool stopped = false;
+    auto emit = [&](const char* word, size_t length) {
+        if (length > 0 && word[length - 1] == '\r') {
+            length--;
+        }
+        if (length > 0 && !visit(word, length)) {
+            stopped = true;
+        }
+    };
+    ssize_t got = 0;
+    while (!stopped && (got = read(fd, buffer.data(), buffer.size())) > 0) {
+        const char* p = buffer.data();
+        const char* end = p + got;
+        while (p < end && !stopped) {
+            const char* newline = static_cast<const char*>(std::memchr(p, '\n', end - p));
+            if (newline == nullptr) {
+                carry.append(p, end - p);
+                break;
+            }
+            if (carry.empty()) {
+                emit(p, newline - p);
+            } else {
+                carry.append(p, newline - p);
+                emit(carry.data(), carry.size());
+                carry.clear();
+            }
+            p = newline + 1;
+        }
+    }
+    if (!stopped && !carry.empty()) {
+        emit(carry.data(), carry.size());
+    }
+    close(fd);
+    return got >= 0;
+}
+
+/**
+ * Mask-file queue
+ * 
+ * --masks FILE runs every mask in the file, in file order, as one index
+ * space: mask k owns [start[k], start[k+1]). Workers take small chunks
+ * from a shared cursor (see RangeCursor), so every mask is spread over all
+ * threads, a thread that reaches the end of one mask carries straight on
+ * into the next, and one chunk can cover several tiny masks. Nobody waits
+ * at a mask boundary. Chunks are cut at mask boundaries only to charge
+ * candidates, time and hits to the right mask.
+ */
+struct MaskCounter {
+    std::atomic<long long> candidates{0};
+    std::atomic<long long> nanos{0};        // thread time
+    std::atomic<long long> firstNanos{-1};  // wall window, from the search start
+    std::atomic<long long> lastNanos{0};
+    std::atomic<int> hits{0};
+};
+
+struct MaskQueue {
+    std::string path;
+    std::vector<Mask> masks;
+    std::vector<long long> start;          // start[k] = first index of mask k, start.back() = total
+    std::unique_ptr<MaskCounter[]> counters;
+    int longest = 0;
+    
+    long long total() const { return start.empty() ? 0 : start.back(); }
+    
+    int maskOf(long long index) const {
+        return static_cast<int>(std::upper_bound(start.begin(), start.end(), index) - start.begin()) - 1;
+    }
+    
+    // FNV-1a over every mask's expanded charsets, in order: two lists with
+    // the same fingerprint lay out the index space identically
+    uint64_t fingerprint() const {
+        uint64_t hash = 0xcbf29ce484222325ull;
+        auto mix = [&](unsigned char c) { hash = (hash ^ c) * 0x100000001b3ull; };
+        for (const auto& mask : masks) {
+            for (const auto& charset : mask.positions) {
+                for (char c : charset) {
+                    mix(static_cast<unsigned char>(c));
+                }
+                mix(0);
+            }
+            mix('\n');
+        }
+        return hash;
+    }
+    
+    /**
+     * Read one mask per line ('#' starts a comment line)
+     */
+    bool load(const std::string& file, std::string& error) {
+        path = file;
+        masks.clear();
+        start.assign(1, 0);
+        long long line = 0;
+        bool readable = forEachWord(file, [&](const char* text, size_t length) {
+            line++;
+            if (text[0] == '#') {
+                return true;
+            }
+            Mask mask;
+            if (!parseMask(std::string(text, length), mask)) {
+                error = "line " + std::to_string(line) + ": invalid mask \"" + std::string(text, length) + "\"";
+                return false;
+            }
+            long long size = mask.keySpace();
+            if (size > std::numeric_limits<long long>::max() - start.back()) {
+                error = "masks exceed a 64-bit index at line " + std::to_string(line);
+                return false;
+            }
+            start.push_back(start.back() + size);
+            longest = std::max(longest, static_cast<int>(mask.positions.size()));
+            masks.push_back(std::move(mask));
+            return true;
+        });
+        if (!readable) {
+            error = "could not read " + file;
+            return false;
+        }
+        if (error.empty() && masks.empty()) {
+            error = file + " has no masks";
+        }
+        counters.reset(new MaskCounter[masks.size()]);
+        return error.empty();
+    }
+    
+    // Widen mask k's wall-clock window to cover [from, to)
+    void markWindow(int k, long long from, long long to) {
+        MaskCounter& counter = counters[k];
+        long long seen = counter.firstNanos.load();
+        while ((seen < 0 || from < seen) && !counter.firstNanos.compare_exchange_weak(seen, from)) {
+        }
+        seen = counter.lastNanos.load();
+        while (to > seen && !counter.lastNanos.compare_exchange_weak(seen, to)) {
+        }
+    }
+} maskQueue;
+
+/**
+ * Dictionary attack wordlist
+ * 
+ * The file is mmapped and scanned once for line starts, keeping only
+ * every 64th as a checkpoint, so a billion-word list costs about 125 MB of
+ * index on top of the page cache. A word's index is its line number, so
+ * ranges, shards, restore points, --expand and --policy work as for the
+ * other sources. Words are one per line with an optional '\r'.
+ */
+struct Wordlist {
+    static const long long CHECKPOINT = 64;
+    
+    std::string path;
+    const char* data = nullptr;
+    size_t size = 0;
+    long long total = 0;
+    int longest = 0;
+    std::vector<uint64_t> checkpoints;   // byte offset of word CHECKPOINT * k
+    
+    ~Wordlist() {
+        if (data != nullptr) {
+            munmap(const_cast<char*>(data), size);
+        }
+    }
+    
+    size_t lineEnd(size_t offset) const {
+        const void* newline = std::memchr(data + offset, '\n', size - offset);
+        return newline ? static_cast<const char*>(newline) - data : size;
+    }
+    
+    // Byte offset of word `index`: a checkpoint, then at most 63 lines
+    size_t seek(long long index) const {
+        size_t offset = checkpoints[index / CHECKPOINT];
+        for (long long k = index % CHECKPOINT; k > 0; --k) {
+            offset = lineEnd(offset) + 1;
+        }
+        return offset;
+    }
+    
+    bool load(const std::string& file, std::string& error) {
+        path = file;
+        int fd = open(file.c_str(), O_RDONLY);
+        struct stat info{};
+        if (fd < 0 || fstat(fd, &info) != 0) {
+            error = "could not open " + file;
+            if (fd >= 0) {
+                close(fd);
+            }
+            return false;
+        }
+        size = static_cast<size_t>(info.st_size);
+        if (size > 0) {
+            void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapped == MAP_FAILED) {
+                close(fd);
+                error = "could not map " + file;
+                return false;
+            }
+            data = static_cast<const char*>(mapped);
+            madvise(mapped, size, MADV_SEQUENTIAL);
+        }
+        close(fd);
+        
+        for (size_t offset = 0; offset < size;) {
+            if (total % CHECKPOINT == 0) {
+                checkpoints.push_back(offset);
+            }
+            size_t end = lineEnd(offset);
+            longest = std::max(longest, static_cast<int>(end - offset));
+            total++;
+            offset = end + 1;
+        }
+        if (total == 0) {
+            error = file + " has no words";
+            return false;
+        }
+        return true;
+    }
+} wordlist;
+
+// --prefix-trie: text wordlist walk that reuses shared-prefix hash states
+struct PrefixSharing {
+    bool enabled = false;
+    std::atomic<long long> hashedBytes{0};   // bytes fed to the hash
+    std::atomic<long long> wordBytes{0};     // bytes of the words walked
+} prefixSharing;
+
+// Ring buffer size of a streamed (compressed) wordlist
+const size_t STREAM_BUFFER_SIZE = 4 << 20;
+
+// Totals of the last streamed run, for the summary, log and JSON report
+struct StreamStats {
+    std::vector<std::string> files;
+    int producers = 0;
+    int workers = 0;
+    int buffers = 0;
+    long long compressedBytes = 0;
+    std::atomic<long long> bytes{0};              // decompressed bytes published
+    std::atomic<long long> producerBusyNanos{0};  // inside gzread()
+    std::atomic<long long> workerBusyNanos{0};    // hashing buffers
+    long long producerBlockedNanos = 0;           // waiting for a free buffer
+    long long workerStarvedNanos = 0;             // waiting for a full buffer
+    double seconds = 0;
+    std::string error;
+    
+    double share(long long nanos, int threads) const {
+        return seconds > 0 && threads > 0 ? nanos / 1e9 / (seconds * threads) : 0.0;
+    }
+    
+    // The stage whose threads spend more of the run blocked on the other
+    const char* bottleneck() const {
+        return share(producerBlockedNanos, producers) > share(workerStarvedNanos, workers)
+            ? "hashing" : "decompression";
+    }
+} streamStats;
+
+// --stdin: block and batch sizes, and totals of the last run
+const size_t STDIN_BLOCK_SIZE = 4 << 20;
+const size_t STDIN_BATCH_SIZE = 64 << 10;
+
+struct StdinStats {
+    int workers = 0;
+    int blocks = 0;
+    std::atomic<long long> bytes{0};
+    std::atomic<long long> batches{0};
+    std::atomic<long long> readNanos{0};          // reader inside poll()/read(2)
+    std::atomic<long long> readerBlockedNanos{0}; // reader waiting for a free block or queue slot
+    std::atomic<long long> starvedNanos{0};       // workers waiting on an empty queue
+    std::atomic<long long> emptyPolls{0};         // pops that found the queue empty
+    double seconds = 0;
+    std::string error;
+    
+    double share(long long nanos, int threads) const {
+        return seconds > 0 && threads > 0 ? nanos / 1e9 / (seconds * threads) : 0.0;
+    }
+    
+    // Starved workers mean the generator is the limit; a blocked reader
+    // means hashing is
+    const char* bottleneck() const {
+        return share(starvedNanos.load(), workers) >= share(readerBlockedNanos.load(), 1)
+            ? "input" : "hashing";
+    }
+} stdinStats;
+
+/**
+ * Compiled wordlist: words grouped by length for lane-parallel hashing
+ * 
+ * `compile-wordlist` turns a text list into this format and --wordlist
+ * recognises it by its magic. Every length gets one bucket. A bucket holds
+ * blocks of COMPILED_LANES words stored column by column: the first byte of
+ * all 16 words, then the second byte, and so on. One aligned 16-byte load
+ * therefore gives the same position of 16 words, and hashBlock16() hashes
+ * a whole block at once. Words keep their input order within a bucket, and
+ * the last block is zero-padded. Indices run bucket by bucket in length
+ * order, so length tiers, --min-length and tier statistics work as they do
+ * for brute force.
+ * 
+ * Layout: CompiledHeader, one CompiledBucketEntry per bucket, then the
+ * bucket data, each bucket starting on a 64-byte boundary.
+ */
+const uint32_t COMPILED_MAGIC = 0x434c5750;   // "PWLC"
+const uint32_t COMPILED_VERSION = 1;
+const int COMPILED_LANES = 16;
+const int COMPILED_MAX_LENGTH = 4096;   // longest word compile-wordlist accepts
+
+struct CompiledHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t buckets;
+    uint32_t lanes;
+    uint64_t words;
+};
+
+struct CompiledBucketEntry {
+    uint32_t length;
+    uint32_t reserved;
+    uint64_t count;
+    uint64_t offset;     // from the start of the file
+};
+
+struct CompiledWordlist {
+    struct Bucket {
+        int length;
+        long long count;
+        long long first;                 // index of the bucket's first word
+        const unsigned char* data;
+    };
+    
+    std::string path;
+    const char* map = nullptr;
+    size_t size = 0;
+    std::vector<Bucket> buckets;
+    std::vector<long long> lengthStart;  // lengthStart[l] = first index of length l
+    long long total = 0;
+    int longest = 0;
+    
+    ~CompiledWordlist() {
+        if (map != nullptr) {
+            munmap(const_cast<char*>(map), size);
+        }
+    }
+    
+    static bool isCompiled(const std::string& file) {
+        std::ifstream in(file, std::ios::binary);
+        uint32_t magic = 0;
+        return in.read(reinterpret_cast<char*>(&magic), sizeof(magic)) && magic == COMPILED_MAGIC;
+    }
+    
+    int bucketOf(long long index) const {
+        int b = 0;
+        while (b + 1 < static_cast<int>(buckets.size()) && index >= buckets[b + 1].first) {
+            b++;
+        }
+        return b;
+    }
+    
+    // Gather word `index` out of its block's columns
+    void decode(long long index, std::string& out) const {
+        const Bucket& bucket = buckets[bucketOf(index)];
+        long long local = index - bucket.first;
+        const unsigned char* block = bucket.data + (local / COMPILED_LANES) * COMPILED_LANES * bucket.length;
+        int lane = static_cast<int>(local % COMPILED_LANES);
+        out.resize(bucket.length);
+        for (int p = 0; p < bucket.length; ++p) {
+            out[p] = static_cast<char>(block[p * COMPILED_LANES + lane]);
+        }
+    }
+    
+    bool load(const std::string& file, std::string& error) {
+        path = file;
+        int fd = open(file.c_str(), O_RDONLY);
+        struct stat info{};
+        if (fd < 0 || fstat(fd, &info) != 0) {
+            error = "could not open " + file;
+            if (fd >= 0) {
+                close(fd);
+            }
+            return false;
+        }
+        size = static_cast<size_t>(info.st_size);
+        void* mapped = size >= sizeof(CompiledHeader)
+            ? mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+        close(fd);
+        if (mapped == MAP_FAILED) {
+            error = "could not map " + file;
+            return false;
+        }
+        map = static_cast<const char*>(mapped);
+        madvise(mapped, size, MADV_SEQUENTIAL);
+        
+        CompiledHeader header;
+        std::memcpy(&header, map, sizeof(header));
+        if (header.magic != COMPILED_MAGIC || header.version != COMPILED_VERSION ||
+            header.lanes != COMPILED_LANES ||
+            sizeof(header) + header.buckets * sizeof(CompiledBucketEntry) > size) {
+            error = file + " is not a version " + std::to_string(COMPILED_VERSION) + " compiled wordlist";
+            return false;
+        }
+        for (uint32_t b = 0; b < header.buckets; ++b) {
+            CompiledBucketEntry entry;
+            std::memcpy(&entry, map + sizeof(header) + b * sizeof(entry), sizeof(entry));
+            // Divide rather than multiply: a forged count must not wrap the bound
+            uint64_t blocks = entry.count / COMPILED_LANES + (entry.count % COMPILED_LANES != 0);
+            if (entry.length == 0 || entry.length > COMPILED_MAX_LENGTH || entry.offset % 64 != 0 ||
+                entry.offset > size ||
+                blocks > (size - entry.offset) / (static_cast<uint64_t>(COMPILED_LANES) * entry.length) ||
+                (b > 0 && static_cast<int>(entry.length) <= buckets.back().length)) {
+                error = file + ": corrupt bucket table";
+                return false;
+            }
+            buckets.push_back({static_cast<int>(entry.length), static_cast<long long>(entry.count), total,
+                               reinterpret_cast<const unsigned char*>(map + entry.offset)});
+            total += entry.count;
+            longest = static_cast<int>(entry.length);
+        }
+        if (total == 0) {
+            error = file + " has no words";
+            return false;
+        }
+        if (header.words != static_cast<uint64_t>(total)) {
+            error = file + ": word count does not match the bucket table";
+            return false;
+        }
+        
+        // Lengths without a bucket are empty tiers
+        lengthStart.assign(longest + 2, total);
+        for (int l = longest; l >= 0; --l) {
+            lengthStart[l] = lengthStart[l + 1];
+            for (const auto& bucket : buckets) {
+                if (bucket.length == l) {
+                    lengthStart[l] = bucket.first;
+                }
+            }
+        }
+        lengthStart[0] = 0;
+        return true;
+    }
+} compiledWordlist;
+
+#ifdef __SSE2__
+/**
+ * simpleHash() of the 16 words of one compiled block
+ * 
+ * Four 4-lane accumulators run h = h * 31 + c as (h << 5) - h + c, which
+ * needs only SSE2 (no 32-bit multiply). Bytes are sign-extended because
+ * simpleHash() widens a plain, signed char.
+ */
+inline void hashBlock16(const unsigned char* block, int length, uint32_t* hashes) {
+    __m128i h[4] = {_mm_setzero_si128(), _mm_setzero_si128(), _mm_setzero_si128(), _mm_setzero_si128()};
+    for (int p = 0; p < length; ++p) {
+        __m128i bytes = _mm_load_si128(reinterpret_cast<const __m128i*>(block + p * COMPILED_LANES));
+        __m128i sign = _mm_cmpgt_epi8(_mm_setzero_si128(), bytes);
+        __m128i low = _mm_unpacklo_epi8(bytes, sign);
+        __m128i high = _mm_unpackhi_epi8(bytes, sign);
+        __m128i c[4] = {
+            _mm_unpacklo_epi16(low, _mm_srai_epi16(low, 15)),
+            _mm_unpackhi_epi16(low, _mm_srai_epi16(low, 15)),
+            _mm_unpacklo_epi16(high, _mm_srai_epi16(high, 15)),
+            _mm_unpackhi_epi16(high, _mm_srai_epi16(high, 15)),
+        };
+        for (int v = 0; v < 4; ++v) {
+            h[v] = _mm_add_epi32(_mm_sub_epi32(_mm_slli_epi32(h[v], 5), h[v]), c[v]);
+        }
+    }
+    for (int v = 0; v < 4; ++v) {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(hashes + 4 * v), h[v]);
+    }
+}
+#else
+inline void hashBlock16(const unsigned char* block, int length, uint32_t* hashes) {
+    for (int lane = 0; lane < COMPILED_LANES; ++lane) {
+        hashes[lane] = 0;
+    }
+    for (int p = 0; p < length; ++p) {
+        for (int lane = 0; lane < COMPILED_LANES; ++lane) {
+            hashes[lane] = simpleHashStep(hashes[lane], static_cast<char>(block[p * COMPILED_LANES + lane]));
+        }
+    }
+}
+#endif
+
+/**
+ * Fill the per-tier table from a source's length boundaries
+ * (lengthStart[l] = first index of length l)
+ */
+void initTierStatsFrom(const std::vector<long long>& lengthStart, int maxLength) {
+    tierStats.tiers = std::min(maxLength, MAX_TIERS);
+    for (int t = 0; t <= tierStats.tiers; ++t) {
+        tierStats.start[t] = lengthStart[t + 1];
+    }
+}
+
+// Base candidates of the current index-addressable source
+long long sourceBaseSize(int maxLength) {
+    switch (candidateSource) {
+        case CandidateSource::Prince: return princeChains.total;
+        case CandidateSource::Keyboard: return keyboardWalks.total;
+        case CandidateSource::Dates: return datePatterns.total;
+        case CandidateSource::Masks: return maskQueue.total();
+        case CandidateSource::Wordlist: return wordlist.total;
+        case CandidateSource::Stream:
+        case CandidateSource::Stdin: return 0;   // unknown until the stream ends
+        case CandidateSource::Compiled:
+            return compiledWordlist.lengthStart[std::min(maxLength, compiledWordlist.longest) + 1];
+        default: return calculateKeySpace(maxLength);
+    }
+}
+
+// Index space of the current source, expansion included
+long long sourceSpaceSize(int maxLength) {
+    return sourceBaseSize(maxLength) * caseLeet.stride;
+}
+
+// First index of the current source's candidates of `length`
+long long sourceLengthStart(int length) {
+    switch (candidateSource) {
+        case CandidateSource::Prince: return princeChains.lengthStart[length] * caseLeet.stride;
+        case CandidateSource::Keyboard: return keyboardWalks.lengthStart[length] * caseLeet.stride;
+        case CandidateSource::Dates: return datePatterns.lengthStart[length] * caseLeet.stride;
+        case CandidateSource::Masks:
+        case CandidateSource::Wordlist:
+        case CandidateSource::Stream:
+        case CandidateSource::Stdin: return 0;   // not ordered by length
+        case CandidateSource::Compiled: return compiledWordlist.lengthStart[length] * caseLeet.stride;
+        default: return calculateKeySpace(length - 1) * caseLeet.stride;
+    }
+}
+
+void initSourceTierStats(int maxLength) {
+    switch (candidateSource) {
+        case CandidateSource::Prince: initTierStatsFrom(princeChains.lengthStart, maxLength); break;
+        case CandidateSource::Keyboard: initTierStatsFrom(keyboardWalks.lengthStart, maxLength); break;
+        case CandidateSource::Dates: initTierStatsFrom(datePatterns.lengthStart, maxLength); break;
+        case CandidateSource::Masks:
+        case CandidateSource::Wordlist:
+        case CandidateSource::Stream:
+        case CandidateSource::Stdin: tierStats.tiers = 0; return;   // not ordered by length
+        case CandidateSource::Compiled: initTierStatsFrom(compiledWordlist.lengthStart, maxLength); break;
+        default: initTierStats(maxLength); break;
+    }
+    for (int t = 0; t <= tierStats.tiers; ++t) {
+        tierStats.start[t] *= caseLeet.stride;
+    }
+}
+
+/**
+ * Publish a matching candidate as the result unless another thread already
+ * did; the caller's unflushed attempts are added to the total under the
+ * result lock so the count printed with the result is exact
+ * 
+ * @return true if this call claimed the result
+ */
+bool claimFound(int threadId, const std::string& candidate, long long attempts,
+                long long& unflushed) {
+    std::lock_guard<std::mutex> lock(searchState.resultMutex);
+    if (searchState.passwordFound.load()) {
+        return false;
+    }
+    searchState.passwordFound.store(true);
+    searchState.stopRequested.store(true);
+    searchState.foundPassword = candidate;
+    searchState.totalAttempts.fetch_add(unflushed);
+    unflushed = 0;
+    
+    std::lock_guard<std::mutex> outputLock(perfMetrics.outputMutex);
+    std::cout << "\n[Thread " << threadId << "] FOUND PASSWORD: \"" 
+              << candidate << "\" (after " << attempts << " attempts)" << std::endl;
+    return true;
+}
+
+/**
+ * Password-policy pre-filter
+ * 
+ * When the target system enforces a policy (length bounds, required
+ * character classes, "3 of 4 classes"), candidates that break it cannot
+ * be the password and are dropped before hashing. Classification looks at
+ * 16 bytes per step with SSE2 compares, building lower/upper/digit
+ * bitmasks; whatever is none of those is special. Only candidates of 16
+ * bytes or more reach the vector loop: shorter ones (nearly all of them)
+ * go through a per-byte table, which measured faster than padding them
+ * into a vector one at a time.
+ */
+enum : unsigned {
+    CLASS_LOWER = 1,
+    CLASS_UPPER = 2,
+    CLASS_DIGIT = 4,
+    CLASS_SPECIAL = 8,
+};
+
+struct PasswordPolicy {
+    bool enabled = false;
+    int minLength = 0;
+    int maxLength = 0;         // 0 = no limit
+    unsigned required = 0;     // CLASS_* bits that must all be present
+    int minClasses = 0;        // at least this many distinct classes
+} passwordPolicy;
+
+#ifdef __SSE2__
+// Bit i set where lo <= byte i <= hi (ASCII ranges, so signed compares work)
+inline unsigned byteRangeMask(__m128i bytes, char lo, char hi) {
+    __m128i above = _mm_cmpgt_epi8(bytes, _mm_set1_epi8(static_cast<char>(lo - 1)));
+    __m128i below = _mm_cmplt_epi8(bytes, _mm_set1_epi8(static_cast<char>(hi + 1)));
+    return static_cast<unsigned>(_mm_movemask_epi8(_mm_and_si128(above, below)));
+}
+#endif
+
+// CLASS_* bit of every byte value, for the scalar path and SSE2 tails
+const std::array<unsigned char, 256> CHARACTER_CLASS = [] {
+    std::array<unsigned char, 256> table{};
+    for (int c = 0; c < 256; ++c) {
+        table[c] = c >= 'a' && c <= 'z' ? CLASS_LOWER : c >= 'A' && c <= 'Z' ? CLASS_UPPER
+                 : c >= '0' && c <= '9' ? CLASS_DIGIT : CLASS_SPECIAL;
+    }
+    return table;
+}();
+
+/**
+ * CLASS_* bits of the character classes present in `text`
+ */
+unsigned classifyCharacters(const char* text, size_t length) {
+    unsigned classes = 0;
+    size_t offset = 0;
+#ifdef __SSE2__
+    for (; offset + 16 <= length; offset += 16) {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + offset));
+        unsigned lower = byteRangeMask(bytes, 'a', 'z');
+        unsigned upper = byteRangeMask(bytes, 'A', 'Z');
+        unsigned digit = byteRangeMask(bytes, '0', '9');
+        if (lower) classes |= CLASS_LOWER;
+        if (upper) classes |= CLASS_UPPER;
+        if (digit) classes |= CLASS_DIGIT;
+        if ((lower | upper | digit) != 0xffffu) classes |= CLASS_SPECIAL;
+    }
+#endif
+    // Most candidates are shorter than 16 bytes; a table lookup per byte
+    // beats padding them out to a vector
+    for (; offset < length; ++offset) {
+        classes |= CHARACTER_CLASS[static_cast<unsigned char>(text[offset])];
+    }
+    return classes;
+}
+
+bool policyAllows(std::string_view candidate) {
+    int length = static_cast<int>(candidate.size());
+    if (length < passwordPolicy.minLength ||
+        (passwordPolicy.maxLength > 0 && length > passwordPolicy.maxLength)) {
+        return false;
+    }
+    unsigned classes = classifyCharacters(candidate.data(), candidate.size());
+    return (classes & passwordPolicy.required) == passwordPolicy.required &&
+           __builtin_popcount(classes) >= passwordPolicy.minClasses;
+}
+
+/**
+ * Parse a policy such as "min=8,upper,digit" or "min=10,classes=3"
+ * 
+ * Numbers must be plain non-negative integers, classes at most 4 and min
+ * no larger than a non-zero max; an empty spec is rejected.
+ */
+bool parsePolicy(const std::string& spec, PasswordPolicy& policy) {
+    if (spec.empty()) {
+        return false;
+    }
+    std::istringstream items(spec);
+    std::string item;
+    while (std::getline(items, item, ',')) {
+        size_t equals = item.find('=');
+        std::string key = item.substr(0, equals);
+        bool numeric = key == "min" || key == "max" || key == "classes";
+        if (numeric != (equals != std::string::npos)) {
+            return false;
+        }
+        long value = 0;
+        if (numeric) {
+            const char* text = item.c_str() + equals + 1;
+            char* end = nullptr;
+            errno = 0;
+            value = std::strtol(text, &end, 10);
+            if (!std::isdigit(static_cast<unsigned char>(*text)) || *end != '\0' ||
+                errno == ERANGE || value > std::numeric_limits<int>::max()) {
+                return false;
+            }
+        }
+        if (key == "min") {
+            policy.minLength = static_cast<int>(value);
+        } else if (key == "max") {
+            policy.maxLength = static_cast<int>(value);
+        } else if (key == "classes") {
+            if (value > 4) {
+                return false;
+            }
+            policy.minClasses = static_cast<int>(value);
+        } else if (key == "lower") {
+            policy.required |= CLASS_LOWER;
+        } else if (key == "upper") {
+            policy.required |= CLASS_UPPER;
+        } else if (key == "digit") {
+            policy.required |= CLASS_DIGIT;
+        } else if (key == "special") {
+            policy.required |= CLASS_SPECIAL;
+        } else {
+            return false;
+        }
+    }
+    if (policy.maxLength > 0 && policy.minLength > policy.maxLength) {
+        return false;
+    }
+    policy.enabled = true;
+    return true;
+}
+
+/**
+ * Composable candidate pipeline
+ * 
+ * Every index-addressable attack is Source -> Transform -> Filter ->
+ * Hasher. The stages are plain structs combined as template arguments,
+ * so the compiler fuses them into one loop with no virtual call per
+ * candidate; a new attack mode is a new stage, not a copy of the loop.
+ * 
+ * - Source:    generate(index, out) writes candidate `index` into `out`
+ * - Transform: stride() slots per source candidate, variants(word) of them
+ *              in use, apply(variant, word) in place (expands = false for
+ *              the identity, which compiles away)
+ * - Filter:    accept(candidate); rejects = false compiles away
+ * - Hasher:    hashBatch(candidates, count, hashes) over a whole batch
+ */
+struct BruteForceSource {
+    int maxLength;
+    void generate(long long index, std::string& out) const {
+        indexToPasswordInto(index, maxLength, out);
+    }
+};
+
+// Sources whose empty candidate means the index ran past the key space
+template <typename Source>
+constexpr bool endsOnEmpty = false;
+template <>
+constexpr bool endsOnEmpty<BruteForceSource> = true;
+
+struct PrinceSource {
+    void generate(long long index, std::string& out) const { princeChains.decode(index, out); }
+};
+
+struct KeyboardSource {
+    void generate(long long index, std::string& out) const { keyboardWalks.decode(index, out); }
+};
+
+struct DateSource {
+    void generate(long long index, std::string& out) const { datePatterns.decode(index, out); }
+};
+
+// Consecutive indices (the common case) continue from the previous word
+struct WordlistSource {
+    mutable long long lastIndex = -2;
+    mutable size_t nextOffset = 0;
+    void generate(long long index, std::string& out) const {
+        size_t offset = index == lastIndex + 1 ? nextOffset : wordlist.seek(index);
+        size_t end = wordlist.lineEnd(offset);
+        size_t length = end - offset;
+        if (length > 0 && wordlist.data[end - 1] == '\r') {
+            length--;
+        }
+        out.assign(wordlist.data + offset, length);
+        lastIndex = index;
+        nextOffset = end + 1;
+    }
+};
+
+struct CompiledWordSource {
+    void generate(long long index, std::string& out) const { compiledWordlist.decode(index, out); }
+};
+
+struct MaskSource {
+    const Mask* mask;
+    long long first = 0;   // index of the mask's first candidate
+    void generate(long long index, std::string& out) const { mask->decode(index - first, out); }
+};
+
+struct IdentityTransform {
+    static constexpr bool expands = false;
+    long long stride() const { return 1; }
+    long long variants(const std::string&) const { return 1; }
+    void apply(long long, std::string&) const {}
+};
+
+struct CaseLeetTransform {
+    static constexpr bool expands = true;
+    long long stride() const { return caseLeet.stride; }
+    long long variants(const std::string& word) const { return caseLeet.variantCount(word); }
+    void apply(long long variant, std::string& word) const { caseLeet.apply(variant, word); }
+};
+
+struct AcceptAll {
+    static constexpr bool rejects = false;
+    bool accept(const std::string&) const { return true; }
+};
+
+struct PolicyFilter {
+    static constexpr bool rejects = true;
+    bool accept(const std::string& candidate) const { return policyAllows(candidate); }
+};
+
+struct SimpleHasher {
+    void hashBatch(const std::string* candidates, int count, uint32_t* hashes) const {
+        for (int k = 0; k < count; ++k) {
+            hashes[k] = simpleHash(candidates[k]);
+        }
+    }
+};
+
+template <typename Source, typename Transform = IdentityTransform, typename Filter = AcceptAll,
+          typename Hasher = SimpleHasher>
+struct CandidatePipeline {
+    static const int BATCH = 64;
+    
+    Source source;
+    Transform transform;
+    Filter filter;
+    Hasher hasher;
+    
+    /**
+     * Search one contiguous slice [startIndex, endIndex) of the index space
+     * 
+     * This is the hot loop shared by every mode that hands index ranges to
+     * a thread. `attempts` is the thread's running total and is updated in
+     * place so progress stays continuous when a thread searches several
+     * slices. Slots a transform leaves empty and candidates a filter
+     * rejects count as attempts but are never hashed. On a find, the
+     * rest of the batch after the matching slot is taken back out of
+     * the counts, so attempts stop exactly at the password.
+     * 
+     * @return true if this call found the password
+     */
+    template <bool Permuted>
+    bool search(int threadId, long long startIndex, long long endIndex, long long& attempts) {
+        std::string batch[BATCH];   // reused, so candidates never allocate once warm
+        uint32_t hashes[BATCH];
+        long long marks[BATCH][3];  // attempts, skipped, filtered as each slot was filled
+        std::string base;           // word whose variants are being expanded
+        long long baseIndex = -1;
+        long long baseVariants = 0;
+        long long unflushed = 0;
+        long long skipped = 0;
+        long long filtered = 0;
+        bool foundHere = false;
+        
+        long long i = startIndex;
+        while (i < endIndex && !searchState.stopRequested.load()) {
+            // Fill a batch
+            int count = 0;
+            for (; count < BATCH && i < endIndex; ++i) {
+                long long position = Permuted ? enumerationOrder.map(i) : i;
+                std::string& slot = batch[count];
+                attempts++;
+                unflushed++;
+                
+                if (Transform::expands) {
+                    long long index = position / transform.stride();
+                    long long variant = position % transform.stride();
+                    if (index != baseIndex) {
+                        source.generate(index, base);
+                        baseIndex = index;
+                        baseVariants = transform.variants(base);
+                    }
+                    if (variant >= baseVariants) {
+                        // In sequential order the word's remaining slots go in one step
+                        long long slots = Permuted ? 1 : std::min(endIndex - i,
+                                                                  transform.stride() - variant);
+                        attempts += slots - 1;
+                        unflushed += slots - 1;
+                        skipped += slots;
+                        i += slots - 1;
+                        continue;
+                    }
+                    slot = base;
+                    transform.apply(variant, slot);
+                } else {
+                    source.generate(position, slot);
+                    if (endsOnEmpty<Source> && slot.empty()) {
+                        // Out of valid range
+                        attempts--;
+                        unflushed--;
+                        endIndex = i;
+                        break;
+                    }
+                }
+                
+                if (Filter::rejects && !filter.accept(slot)) {
+                    skipped++;
+                    filtered++;
+                    continue;
+                }
+                marks[count][0] = attempts;
+                marks[count][1] = skipped;
+                marks[count][2] = filtered;
+                count++;
+            }
+            
+            // Hash it and check the results
+            hasher.hashBatch(batch, count, hashes);
+            for (int k = 0; k < count; ++k) {
+                if (hashes[k] == searchState.targetHash) {
+                    long long excess = attempts - marks[k][0];
+                    attempts -= excess;
+                    unflushed -= excess;
+                    skipped = marks[k][1];
+                    filtered = marks[k][2];
+                    foundHere = claimFound(threadId, batch[k], attempts, unflushed);
+                    break;
+                }
+            }
+            if (foundHere) {
+                break;
+            }
+            
+            // Periodic progress update (every ~50000 attempts)
+            if (unflushed >= 50000) {
+                searchState.totalAttempts.fetch_add(unflushed);
+                threadCounters[threadId].attempts.store(attempts, std::memory_order_relaxed);
+                unflushed = 0;
+            }
+        }
+        
+        // Final attempt count update
+        if (unflushed > 0) {
+            searchState.totalAttempts.fetch_add(unflushed);
+        }
+        if (skipped > 0) {
+            searchState.skippedCandidates.fetch_add(skipped, std::memory_order_relaxed);
+            searchState.filteredCandidates.fetch_add(filtered, std::memory_order_relaxed);
+        }
+        threadCounters[threadId].attempts.store(attempts, std::memory_order_relaxed);
+        
+        return foundHere;
+    }
+};
+
+// Each source, transform and order gets its own fused loop, so the
+// sequential brute-force loop pays nothing for the other modes
+template <typename Source, typename Transform, typename Filter>
+bool searchPipeline(const Source& source, int threadId, long long startIndex, long long endIndex,
+                    long long& attempts) {
+    CandidatePipeline<Source, Transform, Filter> pipeline{source, {}, {}, {}};
+    return enumerationOrder.permuted
+        ? pipeline.template search<true>(threadId, startIndex, endIndex, attempts)
+        : pipeline.template search<false>(threadId, startIndex, endIndex, attempts);
+}
+
+template <typename Source>
+bool searchWith(const Source& source, int threadId, long long startIndex, long long endIndex,
+                long long& attempts) {
+    if (caseLeet.enabled) {
+        return passwordPolicy.enabled
+            ? searchPipeline<Source, CaseLeetTransform, PolicyFilter>(source, threadId, startIndex, endIndex, attempts)
+            : searchPipeline<Source, CaseLeetTransform, AcceptAll>(source, threadId, startIndex, endIndex, attempts);
+    }
+    return passwordPolicy.enabled
+        ? searchPipeline<Source, IdentityTransform, PolicyFilter>(source, threadId, startIndex, endIndex, attempts)
+        : searchPipeline<Source, IdentityTransform, AcceptAll>(source, threadId, startIndex, endIndex, attempts);
+}
+
+/**
+ * Search [startIndex, endIndex) of the mask queue one mask at a time,
+ * charging each piece's candidates, time and hit to its mask
+ */
+bool searchMaskQueue(int threadId, long long startIndex, long long endIndex, long long& attempts) {
+    long long stride = caseLeet.stride;
+    for (long long start = startIndex; start < endIndex;) {
+        int k = maskQueue.maskOf(start / stride);
+        long long end = std::min(endIndex, maskQueue.start[k + 1] * stride);
+        
+        auto pieceStart = std::chrono::steady_clock::now();
+        long long before = attempts;
+        bool found = searchWith(MaskSource{&maskQueue.masks[k], maskQueue.start[k]}, threadId,
+                                start, end, attempts);
+        auto pieceEnd = std::chrono::steady_clock::now();
+        MaskCounter& counter = maskQueue.counters[k];
+        counter.candidates.fetch_add(attempts - before, std::memory_order_relaxed);
+        counter.nanos.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            pieceEnd - pieceStart).count(), std::memory_order_relaxed);
+        maskQueue.markWindow(k,
+            std::chrono::duration_cast<std::chrono::nanoseconds>(pieceStart - searchState.startTime).count(),
+            std::chrono::duration_cast<std::chrono::nanoseconds>(pieceEnd - searchState.startTime).count());
+        
+        if (found) {
+            counter.hits.fetch_add(1);
+            return true;
+        }
+        if (attempts - before < end - start) {
+            return false;  // stopped early
+        }
+        start = end;
+    }
+    return false;
+}
+
+/**
+ * Lane-parallel search of compiled wordlist indices [startIndex, endIndex)
+ * 
+ * Whole blocks go through hashBlock16(); only a lane whose hash matches is
+ * turned into a string, and lanes outside the range are ignored. Used when
+ * no transform or filter has to see each word and the order is sequential.
+ */
+bool searchCompiled(int threadId, long long startIndex, long long endIndex, long long& attempts) {
+    uint32_t hashes[COMPILED_LANES];
+    long long unflushed = 0;
+    bool found = false;
+    
+    for (long long start = startIndex; start < endIndex && !found;) {
+        const CompiledWordlist::Bucket& bucket = compiledWordlist.buckets[compiledWordlist.bucketOf(start)];
+        long long end = std::min(endIndex, bucket.first + bucket.count);
+        long long first = start - bucket.first;
+        long long last = end - bucket.first;
+        
+        for (long long block = first / COMPILED_LANES; block * COMPILED_LANES < last; ++block) {
+            if (searchState.stopRequested.load(std::memory_order_relaxed)) {
+                end = endIndex;   // leave both loops
+                break;
+            }
+            long long blockStart = block * COMPILED_LANES;
+            hashBlock16(bucket.data + blockStart * bucket.length, bucket.length, hashes);
+            long long laneFirst = std::max(first, blockStart);
+            long long laneEnd = std::min(last, blockStart + COMPILED_LANES);
+            attempts += laneEnd - laneFirst;
+            unflushed += laneEnd - laneFirst;
+            for (long long k = laneFirst; k < laneEnd; ++k) {
+                if (hashes[k - blockStart] == searchState.targetHash) {
+                    attempts -= laneEnd - k - 1;   // lanes after the match were not tried
+                    unflushed -= laneEnd - k - 1;
+                    std::string word;
+                    compiledWordlist.decode(bucket.first + k, word);
+                    found = claimFound(threadId, word, attempts, unflushed);
+                    break;
+                }
+            }
+            if (found) {
+                break;
+            }
+            if (unflushed >= 50000) {
+                searchState.totalAttempts.fetch_add(unflushed);
+                threadCounters[threadId].attempts.store(attempts, std::memory_order_relaxed);
+                unflushed = 0;
+            }
+        }
+        start = end;
+    }
+    
+    if (unflushed > 0) {
+        searchState.totalAttempts.fetch_add(unflushed);
+    }
+    threadCounters[threadId].attempts.store(attempts, std::memory_order_relaxed);
+    return found;
+}
+
+/**
+ * Prefix-sharing walk over a text wordlist (--prefix-trie)
+ * 
+ * simpleHash() folds bytes left to right, so the hash of a word extends
+ * the hash of any of its prefixes. prefixHash[i] keeps the state after the
+ * current word's first i bytes; the next word restarts from the state of
+ * the prefix it shares with the current one and hashes only the rest. On a
+ * sorted list (see dedup) this is a depth-first walk of the implicit trie:
+ * "password", "password1", "password12" cost 8 + 1 + 1 bytes. The first
+ * word of a range is hashed whole.
+ */
+bool searchWordlistPrefixes(int threadId, long long startIndex, long long endIndex,
+                            long long& attempts) {
+    std::vector<uint32_t> prefixHash(1, 0);
+    const char* previous = nullptr;
+    size_t previousLength = 0;
+    long long hashedBytes = 0;
+    long long wordBytes = 0;
+    long long unflushed = 0;
+    bool found = false;
+    size_t offset = startIndex < endIndex ? wordlist.seek(startIndex) : 0;
+    
+    for (long long index = startIndex; index < endIndex; ++index) {
+        if ((index & 1023) == 0 && searchState.stopRequested.load(std::memory_order_relaxed)) {
+            break;
+        }
+        size_t end = wordlist.lineEnd(offset);
+        size_t length = end - offset;
+        if (length > 0 && wordlist.data[end - 1] == '\r') {
+            length--;
+        }
+        const char* word = wordlist.data + offset;
+        size_t shared = 0;
+        size_t common = std::min(length, previousLength);
+        while (shared < common && word[shared] == previous[shared]) {
+            shared++;
+        }
+        if (prefixHash.size() <= length) {
+            prefixHash.resize(length + 1);
+        }
+        uint32_t hash = prefixHash[shared];
+        for (size_t p = shared; p < length; ++p) {
+            hash = simpleHashStep(hash, word[p]);
+            prefixHash[p + 1] = hash;
+        }
+        hashedBytes += length - shared;
+        wordBytes += length;
+        previous = word;
+        previousLength = length;
+        offset = end + 1;
+        attempts++;
+        unflushed++;
+        
+        if (hash == searchState.targetHash) {
+            found = claimFound(threadId, std::string(word, length), attempts, unflushed);
+            break;
+        }
+        if (unflushed >= 50000) {
+            searchState.totalAttempts.fetch_add(unflushed);
+            threadCounters[threadId].attempts.store(attempts, std::memory_order_relaxed);
+            unflushed = 0;
+        }
+    }
+    
+    if (unflushed > 0) {
+        searchState.totalAttempts.fetch_add(unflushed);
+    }
+    threadCounters[threadId].attempts.store(attempts, std::memory_order_relaxed);
+    prefixSharing.hashedBytes.fetch_add(hashedBytes, std::memory_order_relaxed);
+    prefixSharing.wordBytes.fetch_add(wordBytes, std::memory_order_relaxed);
+    return found;
+}
+
+bool searchRange(int threadId, long long startIndex, long long endIndex, int maxLength,
+                 long long& attempts) {
+    switch (candidateSource) {
+        case CandidateSource::Prince:
+            return searchWith(PrinceSource{}, threadId, startIndex, endIndex, attempts);
+        case CandidateSource::Keyboard:
+            return searchWith(KeyboardSource{}, threadId, startIndex, endIndex, attempts);
+        case CandidateSource::Dates:
+            return searchWith(DateSource{}, threadId, startIndex, endIndex, attempts);
+        case CandidateSource::Masks:
+            return searchMaskQueue(threadId, startIndex, endIndex, attempts);
+        case CandidateSource::Wordlist:
+            if (prefixSharing.enabled) {
+                return searchWordlistPrefixes(threadId, startIndex, endIndex, attempts);
+            }
+            return searchWith(WordlistSource{}, threadId, startIndex, endIndex, attempts);
+        case CandidateSource::Compiled:
+            if (!caseLeet.enabled && !passwordPolicy.enabled && !enumerationOrder.permuted) {
+                return searchCompiled(threadId, startIndex, endIndex, attempts);
+            }
+            return searchWith(CompiledWordSource{}, threadId, startIndex, endIndex, attempts);
+        default:
+            return searchWith(BruteForceSource{maxLength}, threadId, startIndex, endIndex, attempts);
+    }
+}
+
+/**
+ * Record a finished worker's totals and print its completion line
+ */
+void recordThreadCompletion(int threadId, long long attempts,
+                            std::chrono::steady_clock::time_point threadStartTime) {
+    auto threadEndTime = std::chrono::steady_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+        threadEndTime - threadStartTime).count();
+    
+    // Record performance metrics
+    {
+        std::lock_guard<std::mutex> lock(perfMetrics.logMutex);
+        perfMetrics.threadIds.push_back(threadId);
+        perfMetrics.attemptsPerThread.push_back(attempts);
+        perfMetrics.threadTimes.push_back(duration / 1000.0);
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(perfMetrics.outputMutex);
+        std::cout << "[Thread " << threadId << "] Completed. Attempted " 
+                  << attempts << " passwords in " 
+                  << std::fixed << std::setprecision(2) << (duration / 1000.0) 
+                  << " seconds" << std::endl;
+    }
+}
+
+/**
+ * Restore points
+ * 
+ * When a search is interrupted, each worker records the part of its range
+ * it did not reach; those ranges are written to a small text file that a
+ * later run can resume with --restore.
+ */
+struct RestoreState {
+    std::mutex mutex;
+    std::vector<std::pair<long long, long long>> unfinished;
+} restoreState;
+
+void recordUnfinished(long long start, long long end) {
+    if (start < end) {
+        std::lock_guard<std::mutex> lock(restoreState.mutex);
+        restoreState.unfinished.emplace_back(start, end);
+    }
+}
+
+/**
+ * CPU impact controls for shared hosts
+ * 
+ * All of this acts between chunks; when `enabled` is false the workers
+ * search their whole range in one searchRange() call, exactly as before.
+ */
+struct ThrottleControl {
+    bool enabled = false;          // set before workers start
+    double cpuPercent = 100.0;     // requested duty cycle per thread
+    bool idlePriority = false;     // SCHED_IDLE for worker threads
+    int niceValue = 0;             // 0 = leave unchanged
+    std::atomic<bool> paused{false};
+    std::atomic<long long> busyNanos{0};
+    std::atomic<long long> throttledNanos{0};
+    std::atomic<long long> pausedNanos{0};
+} throttle;
+
+// Indices searched between throttle decisions (~10 ms at typical rates)
+const long long THROTTLE_CHUNK = 250000;
+
+void handlePauseSignal(int) {
+    throttle.paused.store(!throttle.paused.load());
+}
+
+/**
+ * Lower the calling worker thread's scheduling priority if requested
+ */
+void applyWorkerPriority() {
+    if (throttle.idlePriority) {
+        sched_param param{};
+        param.sched_priority = 0;
+        pthread_setschedparam(pthread_self(), SCHED_IDLE, &param);
+    }
+    if (throttle.niceValue != 0) {
+        // On Linux the nice value is per thread when addressed by tid
+        setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), throttle.niceValue);
+    }
+}
+
+/**
+ * Enforce the duty cycle after a chunk that kept the thread busy for
+ * `busy`, and hold the thread while the search is paused
+ */
+void throttleAfterChunk(std::chrono::steady_clock::duration busy) {
+    long long busyNs = std::chrono::duration_cast<std::chrono::nanoseconds>(busy).count();
+    throttle.busyNanos.fetch_add(busyNs, std::memory_order_relaxed);
+    
+    if (throttle.cpuPercent < 100.0) {
+        auto idle = std::chrono::nanoseconds(
+            static_cast<long long>(busyNs * (100.0 - throttle.cpuPercent) / throttle.cpuPercent));
+        auto before = std::chrono::steady_clock::now();
+        std::this_thread::sleep_for(idle);
+        throttle.throttledNanos.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - before).count(), std::memory_order_relaxed);
+    }
+    
+    if (throttle.paused.load()) {
+        auto before = std::chrono::steady_clock::now();
+        while (throttle.paused.load() && !searchState.stopRequested.load()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        }
+        throttle.pausedNanos.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - before).count(), std::memory_order_relaxed);
+    }
+}
+
+/**
+ * Search one tier-aligned piece of a slice for searchSlice(): a plain
+ * searchRange() call, or THROTTLE_CHUNK-sized pieces with a throttle
+ * pause (or pause check) after each when throttling is on
+ */
+bool searchThrottled(int threadId, long long startIndex, long long endIndex, int maxLength,
+                     long long& attempts) {
+    if (!throttle.enabled) {
+        return searchRange(threadId, startIndex, endIndex, maxLength, attempts);
+    }
+    for (long long start = startIndex; start < endIndex && !searchState.stopRequested.load();
+         start += THROTTLE_CHUNK) {
+        auto chunkStart = std::chrono::steady_clock::now();
+        if (searchRange(threadId, start, std::min(endIndex, start + THROTTLE_CHUNK),
+                        maxLength, attempts)) {
+            return true;
+        }
+        throttleAfterChunk(std::chrono::steady_clock::now() - chunkStart);
+    }
+    return false;
+}
+
+/**
+ * Entry point every worker uses to search a slice of the key space
+ * 
+ * Cuts the slice at length-tier boundaries and charges each piece's
+ * candidates and time to its tier, then searches it (throttled if
+ * requested).
+ */
+bool searchSlice(int threadId, long long startIndex, long long endIndex, int maxLength,
+                 long long& attempts) {
+    if (tierStats.tiers == 0) {
+        return searchThrottled(threadId, startIndex, endIndex, maxLength, attempts);
+    }
+    unsigned long long threadBit = 1ULL << std::min(threadId, 63);
+    
+    for (long long start = startIndex; start < endIndex;) {
+        int tier = tierOfIndex(start);
+        long long end = tier >= 0 ? std::min(endIndex, tierStats.start[tier + 1]) : endIndex;
+        
+        auto pieceStart = std::chrono::steady_clock::now();
+        long long before = attempts;
+        bool found = searchThrottled(threadId, start, end, maxLength, attempts);
+        if (tier >= 0) {
+            TierCounter& counter = tierStats.counters[tier];
+            counter.candidates.fetch_add(attempts - before, std::memory_order_relaxed);
+            counter.nanos.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - pieceStart).count(), std::memory_order_relaxed);
+            counter.threadMask.fetch_or(threadBit, std::memory_order_relaxed);
+        }
+        
+        if (found || attempts - before < end - start) {
+            return found;  // stopped early
+        }
+        start = end;
+    }
+    return false;
+}
+
+/**
+ * Static worker: searches its assigned ranges in order
+ * 
+ * A thread normally gets one piece of every length tier the search covers
+ * (see partitionByTier()), or its share of a restore point's pending ranges.
+ */
+void crackerWorker(int threadId, std::vector<std::pair<long long, long long>> ranges, int maxLength) {
+    auto threadStartTime = std::chrono::steady_clock::now();
+    long long attempts = 0;
+    
+    {
+        std::lock_guard<std::mutex> lock(perfMetrics.outputMutex);
+        if (ranges.size() == 1) {
+            std::cout << "[Thread " << threadId << "] Starting search from index " 
+                      << ranges[0].first << " to " << ranges[0].second << std::endl;
+        } else {
+            long long share = 0;
+            for (const auto& range : ranges) {
+                share += range.second - range.first;
+            }
+            std::cout << "[Thread " << threadId << "] Starting search over " << ranges.size()
+                      << " ranges (" << share << " indices)" << std::endl;
+        }
+    }
+    
+    applyWorkerPriority();
+    
+    // Search through assigned portions of key space
+    for (const auto& range : ranges) {
+        if (searchState.stopRequested.load()) {
+            if (searchState.interrupted.load()) {
+                recordUnfinished(range.first, range.second);
+            }
+            continue;
+        }
+        long long before = attempts;
+        searchSlice(threadId, range.first, range.second, maxLength, attempts);
+        if (searchState.interrupted.load()) {
+            recordUnfinished(range.first + (attempts - before), range.second);
+        }
+    }
+    
+    recordThreadCompletion(threadId, attempts, threadStartTime);
+}
+
+/**
+ * Shared cursor over the ranges left to search, handed out strictly in
+ * order so a mask queue is worked through mask by mask
+ */
+struct RangeCursor {
+    std::mutex mutex;
+    std::vector<std::pair<long long, long long>> ranges;
+    size_t next = 0;
+    
+    bool take(long long chunk, long long& start, long long& end) {
+        std::lock_guard<std::mutex> lock(mutex);
+        while (next < ranges.size() && ranges[next].first >= ranges[next].second) {
+            next++;
+        }
+        if (next == ranges.size()) {
+            return false;
+        }
+        start = ranges[next].first;
+        end = std::min(ranges[next].second, start + chunk);
+        ranges[next].first = end;
+        return true;
+    }
+    
+    // After an interrupt: everything no worker took is unfinished
+    void recordRemaining() {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (size_t r = next; r < ranges.size(); ++r) {
+            recordUnfinished(ranges[r].first, ranges[r].second);
+        }
+    }
+};
+
+// Indices per queue chunk: a few milliseconds of work, so masks spread
+// over every thread and the cursor lock stays cold
+const long long QUEUE_CHUNK = 1 << 18;
+
+/**
+ * Queue worker: takes chunks from the cursor until it runs dry
+ */
+void queueWorker(int threadId, RangeCursor& cursor, int maxLength) {
+    auto threadStartTime = std::chrono::steady_clock::now();
+    long long attempts = 0;
+    applyWorkerPriority();
+    
+    long long start = 0, end = 0;
+    while (!searchState.stopRequested.load() && cursor.take(QUEUE_CHUNK, start, end)) {
+        long long before = attempts;
+        searchSlice(threadId, start, end, maxLength, attempts);
+        if (searchState.interrupted.load()) {
+            recordUnfinished(start + (attempts - before), end);
+        }
+    }
+    
+    recordThreadCompletion(threadId, attempts, threadStartTime);
+}
+
+/**
+ * Write the unfinished ranges to `path` (via a temporary file and rename,
+ * so an existing restore point is never left half-written)
+ */
+bool writeRestorePoint(const std::string& path, int maxLength) {
+    std::string temporary = path + ".tmp";
+    {
+        std::ofstream file(temporary);
+        if (!file.is_open()) {
+            return false;
+        }
+        std::lock_guard<std::mutex> lock(restoreState.mutex);
+        std::sort(restoreState.unfinished.begin(), restoreState.unfinished.end());
+        file << "# password cracker restore point\n";
+        file << "target-hash " << searchState.targetHash << "\n";
+        file << "max-length " << maxLength << "\n";
+        file << "range " << searchState.rangeStart << " " << searchState.rangeEnd << "\n";
+        if (candidateSource == CandidateSource::Prince) {
+            file << "source prince " << princeChains.maxElements << " " << princeChains.total
+                 << " " << princeChains.wordlist << "\n";
+        } else if (candidateSource != CandidateSource::BruteForce) {
+            file << "source " << candidateSourceName() << " " << sourceSpaceSize(maxLength) << "\n";
+        }
+        if (caseLeet.enabled) {
+            file << "expand " << (caseLeet.toggleCase ? "case" : "") << (caseLeet.leet ? "leet" : "")
+                 << " " << caseLeet.maxPositions << "\n";
+        }
+        if (enumerationOrder.permuted) {
+            file << "order random " << enumerationOrder.seed << " "
+                 << enumerationOrder.spaceStart << " " << enumerationOrder.size << "\n";
+        }
+        if (candidateSource == CandidateSource::Masks) {
+            if (!restoreState.unfinished.empty()) {
+                // For the reader: where in the queue the run stopped
+                long long first = restoreState.unfinished.front().first / caseLeet.stride;
+                int k = maskQueue.maskOf(first);
+                file << "# mask " << (k + 1) << " of " << maskQueue.masks.size() << " ("
+                     << maskQueue.masks[k].text << "), index " << (first - maskQueue.start[k]) << "\n";
+            }
+            file << "masks " << maskQueue.masks.size() << " " << std::hex << maskQueue.fingerprint()
+                 << std::dec << "\n";
+            file << "mask-file " << maskQueue.path << "\n";
+        }
+        for (const auto& range : restoreState.unfinished) {
+            file << "pending " << range.first << " " << range.second << "\n";
+        }
+        if (!file.good()) {
+            return false;
+        }
+    }
+    return std::rename(temporary.c_str(), path.c_str()) == 0;
+}
+
+bool readRestorePoint(const std::string& path, uint32_t& targetHash, int& maxLength,
+                      std::vector<std::pair<long long, long long>>& pending) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        return false;
+    }
+    const std::string currentOrder = enumerationOrder.permuted
+        ? "random order, seed " + std::to_string(enumerationOrder.seed) : "sequential order";
+    std::string line;
+    std::string source = "brute-force";
+    std::string expansion = "none";
+    std::string order = "sequential order";
+    std::string maskLayout, maskPath;
+    while (std::getline(file, line)) {
+        std::istringstream fields(line);
+        std::string key;
+        fields >> key;
+        if (key == "target-hash") {
+            fields >> targetHash;
+        } else if (key == "max-length") {
+            fields >> maxLength;
+        } else if (key == "range") {
+            fields >> searchState.rangeStart >> searchState.rangeEnd;
+        } else if (key == "order") {
+            std::string kind;
+            uint64_t seed = 0;
+            long long start = 0, size = 0;
+            fields >> kind >> seed >> start >> size;
+            order = kind + " order, seed " + std::to_string(seed);
+            if (kind == "random" && size > 0) {
+                enumerationOrder.setup(start, size, seed);
+            }
+        } else if (key == "source") {
+            // The index space must be rebuilt with the same options
+            int elements = 0;
+            long long total = 0;
+            fields >> source;
+            if (source == "prince") {
+                fields >> elements;
+            }
+            fields >> total;
+            if (source == candidateSourceName() && total != sourceSpaceSize(maxLength)) {
+                std::cerr << "Error: restore point is for a " << source << " space of " << total
+                          << " candidates; pass the same options as the interrupted run\n";
+                return false;
+            }
+        } else if (key == "masks") {
+            std::string count, fingerprint;
+            fields >> count >> fingerprint;
+            maskLayout = count + " " + fingerprint;
+        } else if (key == "mask-file") {
+            std::getline(fields >> std::ws, maskPath);
+        } else if (key == "expand") {
+            std::string positions;
+            fields >> expansion >> positions;
+            expansion += " " + positions;
+        } else if (key == "pending") {
+            long long start = 0, end = 0;
+            fields >> start >> end;
+            if (start < end) {
+                pending.emplace_back(start, end);
+            }
+        }
+    }
+    std::string expected = caseLeet.enabled
+        ? std::string(caseLeet.toggleCase ? "case" : "") + (caseLeet.leet ? "leet" : "") + " " +
+          std::to_string(caseLeet.maxPositions)
+        : "none";
+    if (expansion != expected) {
+        std::cerr << "Error: restore point was written with --expand " << expansion
+                  << ", this run uses " << expected << "\n";
+        return false;
+    }
+    if (source != candidateSourceName()) {
+        std::cerr << "Error: restore point is for a " << source << " run, not "
+                  << candidateSourceName() << "\n";
+        return false;
+    }
+    // The order is captured before the file's own order line replaces it
+    if (order != currentOrder) {
+        std::cerr << "Error: restore point uses " << order << ", this run uses " << currentOrder
+                  << "; pass the same --random-order/--seed as the interrupted run\n";
+        return false;
+    }
+    if (candidateSource == CandidateSource::Masks) {
+        std::ostringstream layout;
+        layout << maskQueue.masks.size() << " " << std::hex << maskQueue.fingerprint();
+        if (maskLayout.empty() ? maskPath != maskQueue.path : maskLayout != layout.str()) {
+            std::cerr << "Error: restore point was written for mask file " << maskPath
+                      << " with a different mask list; pass the same --masks file\n";
+            return false;
+        }
+    }
+    return maxLength > 0;
+}
+
+/**
+ * Split a list of ranges into `parts` groups of (nearly) equal total size,
+ * cutting ranges where a group boundary falls inside them
+ */
+std::vector<std::vector<std::pair<long long, long long>>>
+splitRanges(const std::vector<std::pair<long long, long long>>& ranges, int parts) {
+    long long total = 0;
+    for (const auto& range : ranges) {
+        total += range.second - range.first;
+    }
+    
+    std::vector<std::vector<std::pair<long long, long long>>> groups(parts);
+    int group = 0;
+    long long filled = 0;
+    for (auto range : ranges) {
+        while (range.first < range.second) {
+            long long quota = shardBounds(total, group, parts).second -
+                              shardBounds(total, group, parts).first;
+            long long take = std::min(range.second - range.first, quota - filled);
+            if (take > 0) {
+                groups[group].emplace_back(range.first, range.first + take);
+                range.first += take;
+                filled += take;
+            }
+            if (filled >= quota && group < parts - 1) {
+                group++;
+                filled = 0;
+            }
+        }
+    }
+    return groups;
+}
+
+/**
+ * Tier-aware static partition of [rangeStart, rangeEnd)
+ * 
+ * Every length tier in the range is split evenly across the threads, so
+ * each thread gets the same mix of short and long candidates and all of
+ * them finish at about the same time.
+ */
+std::vector<std::vector<std::pair<long long, long long>>>
+partitionByTier(long long rangeStart, long long rangeEnd, int parts) {
+    std::vector<std::vector<std::pair<long long, long long>>> groups(parts);
+    for (long long start = rangeStart; start < rangeEnd;) {
+        int tier = tierOfIndex(start);
+        long long end = tier >= 0 ? std::min(rangeEnd, tierStats.start[tier + 1]) : rangeEnd;
+        for (int i = 0; i < parts; ++i) {
+            auto piece = shardBounds(end - start, i, parts);
+            if (piece.first < piece.second) {
+                groups[i].emplace_back(start + piece.first, start + piece.second);
+            }
+        }
+        start = end;
+    }
+    return groups;
+}
+
+/**
+ * Move a split point of a --prefix-trie wordlist onto a subtree boundary
+ * 
+ * Scans up to SUBTREE_WINDOW words from `index` and returns the one that
+ * shares the shortest prefix with its predecessor, so neighbouring threads
+ * start on separate branches of the implicit trie and neither re-hashes a
+ * long prefix the other is walking.
+ */
+const long long SUBTREE_WINDOW = 4096;
+
+long long subtreeBoundary(long long index, long long limit) {
+    if (index <= 0 || index >= limit) {
+        return index;
+    }
+    auto lineAt = [](size_t offset, size_t& length) {
+        size_t end = wordlist.lineEnd(offset);
+        length = end - offset;
+        if (length > 0 && wordlist.data[end - 1] == '\r') {
+            length--;
+        }
+        return end;
+    };
+    size_t offset = wordlist.seek(index - 1);
+    size_t previousLength = 0;
+    const char* previous = wordlist.data + offset;
+    offset = lineAt(offset, previousLength) + 1;
+    
+    long long best = index;
+    size_t bestShared = std::numeric_limits<size_t>::max();
+    for (long long k = index; k < std::min(limit, index + SUBTREE_WINDOW); ++k) {
+        size_t length = 0;
+        const char* word = wordlist.data + offset;
+        offset = lineAt(offset, length) + 1;
+        size_t shared = 0;
+        size_t common = std::min(length, previousLength);
+        while (shared < common && word[shared] == previous[shared]) {
+            shared++;
+        }
+        if (shared < bestShared) {
+            best = k;
+            bestShared = shared;
+            if (shared == 0) {
+                break;
+            }
+        }
+        previous = word;
+        previousLength = length;
+    }
+    return best;
+}
+
+// Shift the boundaries between neighbouring threads' shares to subtree
+// boundaries (wordlists have a single tier, so one range per thread)
+void alignToSubtrees(std::vector<std::vector<std::pair<long long, long long>>>& groups) {
+    for (size_t i = 1; i < groups.size(); ++i) {
+        if (groups[i - 1].size() != 1 || groups[i].size() != 1 ||
+            groups[i - 1][0].second != groups[i][0].first) {
+            continue;
+        }
+        long long boundary = subtreeBoundary(groups[i][0].first, groups[i][0].second);
+        groups[i - 1][0].second = boundary;
+        groups[i][0].first = boundary;
+    }
+}
+
+/**
+ * Print an instant progress snapshot from the lock-free counters
+ */
+void printStatusSnapshot() {
+    double elapsed = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - searchState.startTime).count();
+    long long total = searchState.totalAttempts.load(std::memory_order_relaxed);
+    long long keySpace = searchState.keySpaceSize;
+    double rate = elapsed > 0 ? total / elapsed : 0.0;
+    
+    std::lock_guard<std::mutex> lock(perfMetrics.outputMutex);
+    std::cout << "\n[Status] " << std::fixed << std::setprecision(1) << elapsed << "s elapsed, "
+              << total;
+    if (keySpace > 0) {
+        std::cout << " of " << keySpace << " candidates (" << std::setprecision(2)
+                  << 100.0 * total / keySpace << "%), ";
+    } else {
+        std::cout << " candidates (streamed), ";   // size unknown until the stream ends
+    }
+    std::cout << std::setprecision(0) << rate << " attempts/sec";
+    if (rate > 0 && total < keySpace) {
+        std::cout << ", ETA " << std::setprecision(1) << (keySpace - total) / rate << "s";
+    }
+    std::cout << "\n";
+    for (int i = 0; i < threadCounterCount; ++i) {
+        std::cout << "[Status]   Thread " << i << ": "
+                  << threadCounters[i].attempts.load(std::memory_order_relaxed) << " attempts\n";
+    }
+    std::cout << std::flush;
+}
+
+/**
+ * Dedicated signal thread for the local search
+ * 
+ * SIGINT, SIGTERM and SIGUSR1 are blocked before any worker starts, so
+ * they are only ever consumed here: SIGUSR1 prints a snapshot while the
+ * workers keep going, the first SIGINT/SIGTERM asks them to stop (they
+ * record what they did not search), and a second one exits immediately.
+ */
+class SignalSupervisor {
+public:
+    static void blockSignals() {
+        sigset_t set = handledSignals();
+        pthread_sigmask(SIG_BLOCK, &set, nullptr);
+    }
+    
+    void start() {
+        running.store(true);
+        worker = std::thread(&SignalSupervisor::run, this);
+    }
+    
+    void stop() {
+        running.store(false);
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+    
+    ~SignalSupervisor() { stop(); }
+    
+private:
+    static sigset_t handledSignals() {
+        sigset_t set;
+        sigemptyset(&set);
+        sigaddset(&set, SIGINT);
+        sigaddset(&set, SIGTERM);
+        sigaddset(&set, SIGUSR1);
+        return set;
+    }
+    
+    void run() {
+        sigset_t set = handledSignals();
+        timespec timeout{0, 200 * 1000 * 1000};
+        while (running.load()) {
+            int signal = sigtimedwait(&set, nullptr, &timeout);
+            if (signal == SIGUSR1) {
+                printStatusSnapshot();
+            } else if (signal == SIGINT || signal == SIGTERM) {
+                if (searchState.interrupted.exchange(true)) {
+                    std::_Exit(128 + signal);
+                }
+                {
+                    std::lock_guard<std::mutex> lock(perfMetrics.outputMutex);
+                    std::cout << "\n[Signal] " << (signal == SIGINT ? "SIGINT" : "SIGTERM")
+                              << " received, stopping workers (repeat to exit immediately)"
+                              << std::endl;
+                }
+                searchState.stopRequested.store(true);
+            }
+        }
+    }
+    
+    std::atomic<bool> running{false};
+    std::thread worker;
+};
+
+/**
+ * Threads recorded in a tier's mask, e.g. "0,1,3" ("63+" covers ids >= 63)
+ */
+std::string describeThreadMask(unsigned long long mask) {
+    std::string list;
+    for (int i = 0; i < 64; ++i) {
+        if (mask & (1ULL << i)) {
+            if (!list.empty()) {
+                list += ",";
+            }
+            list += std::to_string(i) + (i == 63 ? "+" : "");
+        }
+    }
+    return list.empty() ? "-" : list;
+}
+
+std::string jsonEscape(const std::string& text) {
+    std::ostringstream out;
+    for (unsigned char c : text) {
+        switch (c) {
+        case '"': out << "\\\""; break;
+        case '\\': out << "\\\\"; break;
+        case '\n': out << "\\n"; break;
+        default:
+            if (c < 0x20) {
+                out << "\\u" << std::hex << std::setw(4) << std::setfill('0') << int(c)
+                    << std::dec << std::setfill(' ');
+            } else {
+                out << c;
+            }
+        }
+    }
+    return out.str();
+}
+
+/**
+ * Write the same figures as the performance log as JSON, for tooling
+ */
+void writeJsonReport(const std::string& jsonPath) {
+    std::ofstream json(jsonPath);
+    if (!json.is_open()) {
+        std::cerr << "Warning: Could not open " << jsonPath << " for writing.\n";
+        return;
+    }
+    
+    double duration = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - searchState.startTime).count();
+    long long total = searchState.totalAttempts.load();
+    std::string result = searchState.passwordFound.load() ? "found"
+                       : searchState.interrupted.load() ? "interrupted" : "not-found";
+    
+    json << std::fixed << std::setprecision(3);
+    json << "{\n";
+    json << "  \"result\": \"" << result << "\",\n";
+    if (searchState.passwordFound.load()) {
+        json << "  \"password\": \"" << jsonEscape(searchState.foundPassword) << "\",\n";
+    }
+    json << "  \"target_hash\": " << searchState.targetHash << ",\n";
+    json << "  \"duration_seconds\": " << duration << ",\n";
+    json << "  \"total_attempts\": " << total << ",\n";
+    json << "  \"skipped_candidates\": " << searchState.skippedCandidates.load() << ",\n";
+    json << "  \"filtered_candidates\": " << searchState.filteredCandidates.load() << ",\n";
+    json << "  \"attempts_per_second\": " << (duration > 0 ? total / duration : 0.0) << ",\n";
+    json << "  \"hashed_per_second\": "
+         << (duration > 0 ? searchState.hashedCandidates() / duration : 0.0) << ",\n";
+    json << "  \"range\": {\"shard\": \""
+         << (searchState.shardLabel.empty() ? "1/1" : searchState.shardLabel)
+         << "\", \"start\": " << searchState.rangeStart << ", \"end\": " << searchState.rangeEnd
+         << ", \"full_key_space\": " << searchState.fullKeySpace << "},\n";
+    json << "  \"source\": \"" << candidateSourceName() << "\",\n";
+    if (candidateSource == CandidateSource::Stdin) {
+        const StdinStats& input = stdinStats;
+        json << "  \"stdin\": {\"bytes\": " << input.bytes.load()
+             << ", \"batches\": " << input.batches.load()
+             << ", \"bytes_per_second\": " << (input.seconds > 0 ? input.bytes.load() / input.seconds : 0.0)
+             << ", \"reader_blocked\": " << input.share(input.readerBlockedNanos.load(), 1)
+             << ", \"workers_starved\": " << input.share(input.starvedNanos.load(), input.workers)
+             << ", \"empty_polls\": " << input.emptyPolls.load()
+             << ", \"bottleneck\": \"" << input.bottleneck() << "\"},\n";
+    }
+    if (candidateSource == CandidateSource::Stream) {
+        const StreamStats& stream = streamStats;
+        json << "  \"stream\": {\"files\": " << stream.files.size()
+             << ", \"compressed_bytes\": " << stream.compressedBytes
+             << ", \"bytes\": " << stream.bytes.load()
+             << ", \"decompression_threads\": " << stream.producers
+             << ", \"decompression_busy\": " << stream.share(stream.producerBusyNanos.load(), stream.producers)
+             << ", \"decompression_blocked\": " << stream.share(stream.producerBlockedNanos, stream.producers)
+             << ", \"hashing_busy\": " << stream.share(stream.workerBusyNanos.load(), stream.workers)
+             << ", \"hashing_starved\": " << stream.share(stream.workerStarvedNanos, stream.workers)
+             << ", \"bottleneck\": \"" << stream.bottleneck() << "\"},\n";
+    }
+    if (prefixSharing.enabled) {
+        json << "  \"prefix_sharing\": {\"hashed_bytes\": " << prefixSharing.hashedBytes.load()
+             << ", \"word_bytes\": " << prefixSharing.wordBytes.load() << "},\n";
+    }
+    
+    json << "  \"threads\": [";
+    for (size_t i = 0; i < perfMetrics.attemptsPerThread.size(); ++i) {
+        double seconds = perfMetrics.threadTimes[i];
+        json << (i ? "," : "") << "\n    {\"id\": " << perfMetrics.threadIds[i]
+             << ", \"attempts\": " << perfMetrics.attemptsPerThread[i]
+             << ", \"seconds\": " << seconds
+             << ", \"attempts_per_second\": "
+             << (seconds > 0 ? perfMetrics.attemptsPerThread[i] / seconds : 0.0) << "}";
+    }
+    json << "\n  ],\n";
+    
+    if (!perfMetrics.threadTimeline.empty()) {
+        json << "  \"thread_timeline\": [";
+        for (size_t i = 0; i < perfMetrics.threadTimeline.size(); ++i) {
+            const auto& change = perfMetrics.threadTimeline[i];
+            json << (i ? "," : "") << "\n    {\"seconds\": " << change.seconds
+                 << ", \"from\": " << change.from << ", \"to\": " << change.to
+                 << ", \"reason\": \"" << jsonEscape(change.reason) << "\"}";
+        }
+        json << "\n  ],\n";
+    }
+    
+    json << "  \"tiers\": [";
+    for (int t = 0; t < tierStats.tiers; ++t) {
+        const TierCounter& counter = tierStats.counters[t];
+        double seconds = counter.nanos.load() / 1e9;
+        long long candidates = counter.candidates.load();
+        json << (t ? "," : "") << "\n    {\"length\": " << (t + 1)
+             << ", \"size\": " << (tierStats.start[t + 1] - tierStats.start[t])
+             << ", \"candidates\": " << candidates
+             << ", \"thread_seconds\": " << seconds
+             << ", \"attempts_per_second\": " << (seconds > 0 ? candidates / seconds : 0.0)
+             << ", \"threads\": \"" << describeThreadMask(counter.threadMask.load()) << "\"}";
+    }
+    json << "\n  ]";
+    if (candidateSource == CandidateSource::Masks) {
+        json << ",\n  \"masks\": [";
+        for (size_t k = 0; k < maskQueue.masks.size(); ++k) {
+            const MaskCounter& counter = maskQueue.counters[k];
+            double wall = counter.firstNanos.load() < 0 ? 0.0
+                : (counter.lastNanos.load() - counter.firstNanos.load()) / 1e9;
+            json << (k ? "," : "") << "\n    {\"mask\": \"" << jsonEscape(maskQueue.masks[k].text)
+                 << "\", \"size\": " << (maskQueue.start[k + 1] - maskQueue.start[k]) * caseLeet.stride
+                 << ", \"candidates\": " << counter.candidates.load()
+                 << ", \"seconds\": " << wall
+                 << ", \"thread_seconds\": " << counter.nanos.load() / 1e9
+                 << ", \"hits\": " << counter.hits.load() << "}";
+        }
+        json << "\n  ]";
+    }
+    json << "\n}\n";
+}
+
+/**
+ * Performance logging function
+ * 
+ * Writes performance metrics to a log file for analysis.
+ */
+void logPerformanceMetrics(const std::string& logPath) {
+    std::ofstream logFile(logPath);
+    if (!logFile.is_open()) {
+        std::cerr << "Warning: Could not open " << logPath << " for writing.\n";
+        return;
+    }
+    
+    auto endTime = std::chrono::steady_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+        endTime - searchState.startTime).count();
+    
+    logFile << "═══════════════════════════════════════════════════\n";
+    logFile << "  PASSWORD CRACKER PERFORMANCE REPORT\n";
+    logFile << "═══════════════════════════════════════════════════\n\n";
+    
+    logFile << "Total Search Duration: " << std::fixed << std::setprecision(3) 
+            << (duration / 1000.0) << " seconds\n\n";
+    
+    // Range and outcome, so reports from separate shards can be merged
+    logFile << "Search Range:\n";
+    logFile << "  Shard: " << (searchState.shardLabel.empty() ? "1/1" : searchState.shardLabel) << "\n";
+    if (candidateSource == CandidateSource::Stream || candidateSource == CandidateSource::Stdin) {
+        // Streamed words have no index range; the count is known only afterwards
+        logFile << "  Lines Read: " << searchState.totalAttempts.load()
+                << " (non-empty, streamed; no index range)\n";
+    } else {
+        logFile << "  Indices: " << searchState.rangeStart << " to " << searchState.rangeEnd
+                << " (" << (searchState.rangeEnd - searchState.rangeStart) << " candidates)\n";
+        logFile << "  Full Key Space: " << searchState.fullKeySpace << "\n";
+    }
+    if (candidateSource == CandidateSource::Stream) {
+        logFile << "  Source: " << streamStats.files.size() << " gzip-compressed wordlist"
+                << (streamStats.files.size() == 1 ? "" : "s") << ":";
+        for (const auto& path : streamStats.files) {
+            logFile << " " << path;
+        }
+        logFile << "\n";
+    } else if (candidateSource == CandidateSource::Stdin) {
+        logFile << "  Source: standard input, " << stdinStats.bytes.load() << " bytes\n";
+    } else if (candidateSource == CandidateSource::Prince) {
+        logFile << "  Source: PRINCE chains (" << princeChains.elementCount << " elements from "
+                << princeChains.wordlist << ", up to " << princeChains.maxElements << " per chain)\n";
+    } else if (candidateSource == CandidateSource::Pcfg) {
+        logFile << "  Source: PCFG guesses in descending probability (indices count guesses)\n";
+    } else if (candidateSource == CandidateSource::Masks) {
+        logFile << "  Source: " << maskQueue.masks.size() << " masks from " << maskQueue.path << "\n";
+    } else if (candidateSource == CandidateSource::Wordlist) {
+        logFile << "  Source: " << wordlist.total << " words from " << wordlist.path << "\n";
+    } else if (candidateSource == CandidateSource::Compiled) {
+        logFile << "  Source: " << compiledWordlist.total << " words from compiled wordlist "
+                << compiledWordlist.path << "\n";
+    } else if (candidateSource != CandidateSource::BruteForce) {
+        logFile << "  Source: " << candidateSourceName() << " patterns\n";
+    }
+    if (enumerationOrder.permuted) {
+        logFile << "  Order: random permutation, seed " << enumerationOrder.seed
+                << " (indices above are positions)\n";
+    }
+    if (searchState.passwordFound.load()) {
+        logFile << "  Result: FOUND \"" << searchState.foundPassword << "\"\n\n";
+    } else if (searchState.interrupted.load()) {
+        logFile << "  Result: INTERRUPTED\n\n";
+    } else {
+        logFile << "  Result: NOT FOUND\n\n";
+    }
+    
+    logFile << "Throughput Metrics:\n";
+    logFile << "  Total Attempts: " << searchState.totalAttempts.load() << "\n";
+    if (caseLeet.enabled) {
+        logFile << "  Empty Variant Slots Skipped: "
+                << (searchState.skippedCandidates.load() - searchState.filteredCandidates.load())
+                << " (not hashed)\n";
+    }
+    if (passwordPolicy.enabled) {
+        logFile << "  Policy Rejects: " << searchState.filteredCandidates.load()
+                << " (hashes avoided)\n";
+    }
+    if (prefixSharing.enabled && searchState.totalAttempts.load() > 0) {
+        double words = static_cast<double>(searchState.totalAttempts.load());
+        logFile << "  Bytes Hashed per Word: " << std::fixed << std::setprecision(2)
+                << prefixSharing.hashedBytes.load() / words << " of "
+                << prefixSharing.wordBytes.load() / words << " (prefix sharing)\n";
+    }
+    
+    if (duration > 0 && searchState.skippedCandidates.load() > 0) {
+        logFile << "  Hashed per Second: " << std::fixed << std::setprecision(2)
+                << (searchState.hashedCandidates() * 1000.0 / duration)
+                << " candidates/sec (skipped slots and policy rejects excluded)\n\n";
+    } else if (duration > 0) {
+        logFile << "  Attempts per Second: " << std::fixed << std::setprecision(2)
+                << (searchState.totalAttempts.load() * 1000.0 / duration) 
+                << " attempts/sec\n\n";
+    } else {
+        logFile << "  Attempts per Second: N/A (duration too short)\n\n";
+    }
+    
+    if (throttle.enabled || throttle.idlePriority || throttle.niceValue != 0) {
+        double busy = throttle.busyNanos.load() / 1e9;
+        double throttled = throttle.throttledNanos.load() / 1e9;
+        logFile << "CPU Throttle:\n";
+        logFile << "  Requested Utilisation: " << std::fixed << std::setprecision(1)
+                << throttle.cpuPercent << "% per thread\n";
+        if (busy + throttled > 0) {
+            logFile << "  Effective Utilisation: " << std::fixed << std::setprecision(1)
+                    << (100.0 * busy / (busy + throttled)) << "% per thread\n";
+        }
+        logFile << "  Time Paused: " << std::fixed << std::setprecision(2)
+                << (throttle.pausedNanos.load() / 1e9) << " thread-seconds\n";
+        logFile << "  Scheduling: " << (throttle.idlePriority ? "SCHED_IDLE" : "default");
+        if (throttle.niceValue != 0) {
+            logFile << ", nice " << throttle.niceValue;
+        }
+        logFile << "\n\n";
+    }
+    
+    if (tierStats.tiers > 0) {
+        logFile << "Length Tier Breakdown:\n";
+        for (int t = 0; t < tierStats.tiers; ++t) {
+            const TierCounter& counter = tierStats.counters[t];
+            long long size = tierStats.start[t + 1] - tierStats.start[t];
+            long long candidates = counter.candidates.load();
+            double seconds = counter.nanos.load() / 1e9;
+            if (candidates == 0) {
+                continue;
+            }
+            logFile << "  Length " << (t + 1) << ":\n";
+            logFile << "    Candidates: " << candidates << " of " << size << " ("
+                    << std::fixed << std::setprecision(1) << (100.0 * candidates / size) << "%)\n";
+            logFile << "    Time: " << std::fixed << std::setprecision(3) << seconds
+                    << " thread-seconds\n";
+            if (seconds > 0) {
+                logFile << "    Speed: " << std::fixed << std::setprecision(2)
+                        << (candidates / seconds) << " attempts/sec per thread\n";
+            }
+            logFile << "    Threads: " << describeThreadMask(counter.threadMask.load()) << "\n";
+        }
+        logFile << "\n";
+    }
+    
+    if (candidateSource == CandidateSource::Masks) {
+        logFile << "Mask Queue:\n";
+        for (size_t k = 0; k < maskQueue.masks.size(); ++k) {
+            const MaskCounter& counter = maskQueue.counters[k];
+            long long size = (maskQueue.start[k + 1] - maskQueue.start[k]) * caseLeet.stride;
+            long long candidates = counter.candidates.load();
+            double seconds = counter.nanos.load() / 1e9;
+            double wall = counter.firstNanos.load() < 0 ? 0.0
+                : (counter.lastNanos.load() - counter.firstNanos.load()) / 1e9;
+            logFile << "  Mask " << (k + 1) << ": " << maskQueue.masks[k].text << "\n";
+            logFile << "    Candidates: " << candidates << " of " << size << " ("
+                    << std::fixed << std::setprecision(1) << (100.0 * candidates / size) << "%)\n";
+            logFile << "    Time: " << std::fixed << std::setprecision(3) << wall << " seconds ("
+                    << seconds << " thread-seconds)\n";
+            logFile << "    Hits: " << counter.hits.load() << "\n";
+        }
+        logFile << "\n";
+    }
+    
+    if (candidateSource == CandidateSource::Stdin) {
+        const StdinStats& input = stdinStats;
+        logFile << "Stdin Pipeline:\n";
+        logFile << "  Bytes Read: " << input.bytes.load() << "\n";
+        logFile << "  Batches: " << input.batches.load() << " (about " << STDIN_BATCH_SIZE
+                << " bytes, from " << input.blocks << " blocks of " << STDIN_BLOCK_SIZE << " bytes)\n";
+        logFile << "  Throughput: " << std::fixed << std::setprecision(2)
+                << (input.seconds > 0 ? input.bytes.load() / 1e6 / input.seconds : 0.0) << " MB/s\n";
+        logFile << "  Reader: " << std::setprecision(1) << 100 * input.share(input.readNanos.load(), 1)
+                << "% in poll/read, " << 100 * input.share(input.readerBlockedNanos.load(), 1)
+                << "% blocked on busy workers\n";
+        logFile << "  Workers: " << input.workers << " ("
+                << 100 * input.share(input.starvedNanos.load(), input.workers)
+                << "% starved on an empty queue, " << input.emptyPolls.load() << " empty polls)\n";
+        logFile << "  Bottleneck: " << input.bottleneck() << "\n\n";
+    }
+    if (candidateSource == CandidateSource::Stream) {
+        const StreamStats& stream = streamStats;
+        logFile << "Stream Pipeline:\n";
+        for (const auto& path : stream.files) {
+            logFile << "  File: " << path << "\n";
+        }
+        logFile << "  Compressed: " << stream.compressedBytes << " bytes\n";
+        logFile << "  Decompressed: " << stream.bytes.load() << " bytes\n";
+        logFile << "  Ring: " << stream.buffers << " buffers of " << STREAM_BUFFER_SIZE << " bytes\n";
+        logFile << "  Decompression Threads: " << stream.producers << " ("
+                << std::fixed << std::setprecision(1)
+                << 100 * stream.share(stream.producerBusyNanos.load(), stream.producers) << "% busy, "
+                << 100 * stream.share(stream.producerBlockedNanos, stream.producers)
+                << "% blocked on a full ring)\n";
+        logFile << "  Hashing Threads: " << stream.workers << " ("
+                << 100 * stream.share(stream.workerBusyNanos.load(), stream.workers) << "% busy, "
+                << 100 * stream.share(stream.workerStarvedNanos, stream.workers)
+                << "% starved waiting for data)\n";
+        logFile << "  Bottleneck: " << stream.bottleneck() << "\n\n";
+    }
+    
+    if (!perfMetrics.threadTimeline.empty()) {
+        logFile << "Thread Count Timeline:\n";
+        for (const auto& change : perfMetrics.threadTimeline) {
+            logFile << "  " << std::fixed << std::setprecision(3) << change.seconds << "s: "
+                    << change.from << " -> " << change.to << " (" << change.reason << ")\n";
+        }
+        logFile << "\n";
+    }
+    
+    logFile << "Thread Performance:\n";
+    for (size_t i = 0; i < perfMetrics.attemptsPerThread.size(); ++i) {
+        logFile << "  Thread " << perfMetrics.threadIds[i] << ":\n";
+        logFile << "    Attempts: " << perfMetrics.attemptsPerThread[i] << "\n";
+        logFile << "    Time: " << std::fixed << std::setprecision(2) 
+                << perfMetrics.threadTimes[i] << " seconds\n";
+        
+        if (perfMetrics.threadTimes[i] > 0) {
+            logFile << "    Speed: " << std::fixed << std::setprecision(2)
+                    << (perfMetrics.attemptsPerThread[i] / perfMetrics.threadTimes[i])
+                    << " attempts/sec\n";
+        }
+        logFile << "\n";
+    }
+    
+    logFile << "═══════════════════════════════════════════════════\n";
+    logFile.close();
+}
+
+/**
+ * Render current search progress in Prometheus text exposition format
+ * 
+ * Reads only the atomic counters the workers already publish, so scraping
+ * never takes a lock that a worker could be waiting on.
+ */
+std::string renderPrometheusMetrics() {
+    auto now = std::chrono::steady_clock::now();
+    double elapsed = std::chrono::duration<double>(now - searchState.startTime).count();
+    long long total = searchState.totalAttempts.load(std::memory_order_relaxed);
+    long long keySpace = searchState.keySpaceSize;
+    bool found = searchState.passwordFound.load(std::memory_order_relaxed);
+    
+    double rate = elapsed > 0 ? total / elapsed : 0.0;
+    double coverage = keySpace > 0 ? static_cast<double>(total) / keySpace : 0.0;
+    double eta = (!found && rate > 0 && keySpace > total) ? (keySpace - total) / rate : 0.0;
+    
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(3);
+    out << "# HELP cracker_attempts_total Candidates hashed so far.\n";
+    out << "# TYPE cracker_attempts_total counter\n";
+    out << "cracker_attempts_total " << total << "\n";
+    out << "# HELP cracker_thread_attempts_total Candidates hashed per worker thread.\n";
+    out << "# TYPE cracker_thread_attempts_total counter\n";
+    for (int i = 0; i < threadCounterCount; ++i) {
+        out << "cracker_thread_attempts_total{thread=\"" << i << "\"} "
+            << threadCounters[i].attempts.load(std::memory_order_relaxed) << "\n";
+    }
+    out << "# HELP cracker_candidates_per_second Average hashing rate since start.\n";
+    out << "# TYPE cracker_candidates_per_second gauge\n";
+    out << "cracker_candidates_per_second " << rate << "\n";
+    out << "# HELP cracker_keyspace_size Total candidates in the search space.\n";
+    out << "# TYPE cracker_keyspace_size gauge\n";
+    out << "cracker_keyspace_size " << keySpace << "\n";
+    out << "# HELP cracker_keyspace_coverage_ratio Fraction of the key space searched.\n";
+    out << "# TYPE cracker_keyspace_coverage_ratio gauge\n";
+    out << "cracker_keyspace_coverage_ratio " << std::setprecision(6) << coverage << "\n";
+    out << "# HELP cracker_targets_remaining Target hashes not yet cracked.\n";
+    out << "# TYPE cracker_targets_remaining gauge\n";
+    out << "cracker_targets_remaining " << (found ? 0 : 1) << "\n";
+    out << "# HELP cracker_eta_seconds Estimated seconds to exhaust the key space.\n";
+    out << "# TYPE cracker_eta_seconds gauge\n";
+    out << "cracker_eta_seconds " << std::setprecision(3) << eta << "\n";
+    out << "# HELP cracker_elapsed_seconds Seconds since the search started.\n";
+    out << "# TYPE cracker_elapsed_seconds gauge\n";
+    out << "cracker_elapsed_seconds " << elapsed << "\n";
+    return out.str();
+}
+
+/**
+ * Open a listening TCP socket on bindAddress:port
+ * 
+ * @return the socket descriptor, or -1 on failure
+ */
+int openListener(const std::string& bindAddress, int port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    int yes = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+    
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(port));
+    if (inet_pton(AF_INET, bindAddress.c_str(), &addr.sin_addr) != 1 ||
+        bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 ||
+        listen(fd, 16) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/**
+ * Connect to a "host:port" TCP endpoint
+ * 
+ * @return the socket descriptor, or -1 on failure
+ */
+int connectTo(const std::string& hostPort) {
+    size_t colon = hostPort.rfind(':');
+    if (colon == std::string::npos) {
+        return -1;
+    }
+    std::string host = hostPort.substr(0, colon);
+    std::string port = hostPort.substr(colon + 1);
+    
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* results = nullptr;
+    if (getaddrinfo(host.c_str(), port.c_str(), &hints, &results) != 0) {
+        return -1;
+    }
+    
+    int fd = -1;
+    for (addrinfo* ai = results; ai != nullptr; ai = ai->ai_next) {
+        fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (fd < 0) {
+            continue;
+        }
+        if (connect(fd, ai->ai_addr, ai->ai_addrlen) == 0) {
+            break;
+        }
+        close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(results);
+    return fd;
+}
+
+/**
+ * Newline-delimited text protocol over a connected socket
+ * 
+ * Owns the descriptor; reads are buffered so several lines arriving in one
+ * segment are returned one at a time.
+ */
+class LineChannel {
+public:
+    explicit LineChannel(int fd) : fd(fd) {}
+    ~LineChannel() {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+    LineChannel(const LineChannel&) = delete;
+    LineChannel& operator=(const LineChannel&) = delete;
+    
+    bool sendLine(const std::string& line) {
+        std::string data = line + "\n";
+        size_t sent = 0;
+        while (sent < data.size()) {
+            ssize_t n = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+            if (n <= 0) {
+                return false;
+            }
+            sent += static_cast<size_t>(n);
+        }
+        return true;
+    }
+    
+    /**
+     * Read one line (without the newline)
+     * 
+     * @return 1 when a line was read, 0 on timeout, -1 if the peer closed
+     */
+    int readLine(std::string& line, int timeoutMs) {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+        while (true) {
+            size_t newline = buffer.find('\n');
+            if (newline != std::string::npos) {
+                line = buffer.substr(0, newline);
+                buffer.erase(0, newline + 1);
+                return 1;
+            }
+            
+            auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+                deadline - std::chrono::steady_clock::now()).count();
+            if (remaining <= 0) {
+                return 0;
+            }
+            pollfd pfd{fd, POLLIN, 0};
+            int ready = poll(&pfd, 1, static_cast<int>(remaining));
+            if (ready < 0) {
+                return -1;
+            }
+            if (ready == 0) {
+                return 0;
+            }
+            
+            char chunk[4096];
+            ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+            if (n <= 0) {
+                return -1;
+            }
+            buffer.append(chunk, static_cast<size_t>(n));
+        }
+    }
+    
+private:
+    int fd;
+    std::string buffer;
+};
+
+/**
+ * Minimal HTTP listener serving GET /metrics
+ * 
+ * Runs on its own thread, polling with a short timeout so it notices the
+ * stop flag; each request is answered and the connection closed.
+ */
+class MetricsServer {
+public:
+    bool start(const std::string& bindAddress, int port) {
+        listenFd = openListener(bindAddress, port);
+        if (listenFd < 0) {
+            return false;
+        }
+        
+        running.store(true);
+        serverThread = std::thread(&MetricsServer::serve, this);
+        return true;
+    }
+    
+    void stop() {
+        running.store(false);
+        if (serverThread.joinable()) {
+            serverThread.join();
+        }
+        if (listenFd >= 0) {
+            close(listenFd);
+            listenFd = -1;
+        }
+    }
+    
+    ~MetricsServer() { stop(); }
+    
+private:
+    void serve() {
+        while (running.load()) {
+            pollfd pfd{listenFd, POLLIN, 0};
+            if (poll(&pfd, 1, 200) <= 0) {
+                continue;
+            }
+            int client = accept(listenFd, nullptr, nullptr);
+            if (client < 0) {
+                continue;
+            }
+            handle(client);
+            close(client);
+        }
+    }
+    
+    void handle(int client) {
+        char buffer[1024];
+        pollfd pfd{client, POLLIN, 0};
+        if (poll(&pfd, 1, 1000) <= 0) {
+            return;
+        }
+        ssize_t n = recv(client, buffer, sizeof(buffer) - 1, 0);
+        if (n <= 0) {
+            return;
+        }
+        buffer[n] = '\0';
+        
+        std::string status = "200 OK";
+        std::string body;
+        if (std::strncmp(buffer, "GET /metrics", 12) == 0) {
+            body = renderPrometheusMetrics();
+        } else {
+            status = "404 Not Found";
+            body = "not found\n";
+        }
+        
+        std::ostringstream response;
+        response << "HTTP/1.0 " << status << "\r\n"
+                 << "Content-Type: text/plain; version=0.0.4\r\n"
+                 << "Content-Length: " << body.size() << "\r\n"
+                 << "Connection: close\r\n\r\n"
+                 << body;
+        std::string data = response.str();
+        send(client, data.data(), data.size(), MSG_NOSIGNAL);
+    }
+    
+    int listenFd = -1;
+    std::atomic<bool> running{false};
+    std::thread serverThread;
+};
+
+/**
+ * A leased slice of the key space handed to one remote worker process
+ */
+struct Lease {
+    long long id = 0;
+    long long start = 0;
+    long long end = 0;
+    int owner = -1;
+    std::chrono::steady_clock::time_point deadline;
+};
+
+/**
+ * Coordinator-side bookkeeping of the key space
+ * 
+ * Hands out fixed-size index chunks, takes back chunks whose worker died
+ * or whose lease expired, and decides when the search is over.
+ */
+class LeaseTable {
+public:
+    enum class Grant { Chunk, Wait, Stop };
+    
+    LeaseTable(long long rangeStart, long long rangeEnd, long long leaseSize,
+               std::chrono::seconds timeout)
+        : rangeEnd(rangeEnd), leaseSize(leaseSize), timeout(timeout), nextIndex(rangeStart) {}
+    
+    Grant acquire(int owner, Lease& lease) {
+        std::lock_guard<std::mutex> lock(mutex);
+        reclaimExpiredLocked();
+        
+        if (found) {
+            return Grant::Stop;
+        }
+        
+        long long start, end;
+        if (!pending.empty()) {
+            start = pending.front().first;
+            end = pending.front().second;
+            pending.pop_front();
+        } else if (nextIndex < rangeEnd) {
+            start = nextIndex;
+            end = std::min(rangeEnd, nextIndex + leaseSize);
+            nextIndex = end;
+        } else {
+            return active.empty() ? Grant::Stop : Grant::Wait;
+        }
+        
+        lease.id = nextLeaseId++;
+        lease.start = start;
+        lease.end = end;
+        lease.owner = owner;
+        lease.deadline = std::chrono::steady_clock::now() + timeout;
+        active[lease.id] = lease;
+        return Grant::Chunk;
+    }
+    
+    // The worker has begun searching a lease it had queued: restart its
+    // clock so time spent waiting in the local prefetch queue does not count
+    void start(int owner, long long leaseId) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = active.find(leaseId);
+        if (it != active.end() && it->second.owner == owner) {
+            it->second.deadline = std::chrono::steady_clock::now() + timeout;
+        }
+    }
+    
+    // False for a late DONE on a lease that expired or was re-leased; its
+    // range is searched again, so its attempts must not be counted twice
+    bool complete(int owner, long long leaseId) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = active.find(leaseId);
+        if (it == active.end() || it->second.owner != owner) {
+            return false;
+        }
+        active.erase(it);
+        return true;
+    }
+    
+    void releaseOwner(int owner) {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto it = active.begin(); it != active.end();) {
+            if (it->second.owner == owner) {
+                pending.emplace_back(it->second.start, it->second.end);
+                reclaimed++;
+                it = active.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+    
+    void reportFound(const std::string& password) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!found) {
+            found = true;
+            foundPassword = password;
+        }
+    }
+    
+    bool finished() {
+        std::lock_guard<std::mutex> lock(mutex);
+        reclaimExpiredLocked();
+        return found || (nextIndex >= rangeEnd && pending.empty() && active.empty());
+    }
+    
+    bool isFound() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return found;
+    }
+    
+    std::string password() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return foundPassword;
+    }
+    
+    long long reclaimedCount() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return reclaimed;
+    }
+    
+private:
+    void reclaimExpiredLocked() {
+        auto now = std::chrono::steady_clock::now();
+        for (auto it = active.begin(); it != active.end();) {
+            if (it->second.deadline <= now) {
+                pending.emplace_back(it->second.start, it->second.end);
+                reclaimed++;
+                it = active.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+    
+    std::mutex mutex;
+    long long rangeEnd;
+    long long leaseSize;
+    std::chrono::seconds timeout;
+    long long nextIndex;
+    long long nextLeaseId = 1;
+    long long reclaimed = 0;
+    std::deque<std::pair<long long, long long>> pending;
+    std::map<long long, Lease> active;
+    bool found = false;
+    std::string foundPassword;
+};
+
+// Per-connection throughput as seen by the coordinator
+struct RemoteWorkerStats {
+    std::string name;
+    int threads = 0;
+    long long attempts = 0;
+    long long chunks = 0;
+};
+
+struct CoordinatorShared {
+    LeaseTable* table = nullptr;
+    int maxLength = 0;
+    std::mutex statsMutex;
+    std::map<int, RemoteWorkerStats> workers;
+    std::atomic<int> openConnections{0};
+    std::atomic<bool> shutdown{false};
+};
+
+/**
+ * Serve one worker process connection on the coordinator
+ * 
+ * Protocol (one request, one reply):
+ *   HELLO <threads>            -> JOB <targetHash> <maxLength>
+ *   LEASE                      -> CHUNK <id> <start> <end> | WAIT | STOP FOUND | STOP EXHAUSTED
+ *   START <id>                 -> OK (lease left the local queue; its timeout restarts)
+ *   DONE <id> <attempts>       -> OK
+ *   FOUND <id> <password>      -> OK | ERROR hash mismatch
+ */
+void serveRemoteWorker(int fd, int owner, CoordinatorShared& shared) {
+    LineChannel channel(fd);
+    LeaseTable& table = *shared.table;
+    std::string line;
+    
+    while (!shared.shutdown.load()) {
+        int status = channel.readLine(line, 500);
+        if (status == 0) {
+            continue;
+        }
+        if (status < 0) {
+            break;
+        }
+        
+        std::istringstream request(line);
+        std::string command;
+        request >> command;
+        
+        bool ok = true;
+        if (command == "HELLO") {
+            int threads = 0;
+            request >> threads;
+            {
+                std::lock_guard<std::mutex> lock(shared.statsMutex);
+                shared.workers[owner].threads = threads;
+            }
+            ok = channel.sendLine("JOB " + std::to_string(searchState.targetHash) + " " +
+                                  std::to_string(shared.maxLength));
+        } else if (command == "LEASE") {
+            Lease lease;
+            switch (table.acquire(owner, lease)) {
+            case LeaseTable::Grant::Chunk:
+                ok = channel.sendLine("CHUNK " + std::to_string(lease.id) + " " +
+                                      std::to_string(lease.start) + " " + std::to_string(lease.end));
+                break;
+            case LeaseTable::Grant::Wait:
+                ok = channel.sendLine("WAIT");
+                break;
+            case LeaseTable::Grant::Stop:
+                ok = channel.sendLine(table.isFound() ? "STOP FOUND" : "STOP EXHAUSTED");
+                break;
+            }
+        } else if (command == "START") {
+            long long leaseId = 0;
+            request >> leaseId;
+            table.start(owner, leaseId);
+            ok = channel.sendLine("OK");
+        } else if (command == "DONE") {
+            long long leaseId = 0, attempts = 0;
+            request >> leaseId >> attempts;
+            if (table.complete(owner, leaseId)) {
+                searchState.totalAttempts.fetch_add(attempts);
+                std::lock_guard<std::mutex> lock(shared.statsMutex);
+                shared.workers[owner].attempts += attempts;
+                shared.workers[owner].chunks++;
+            }
+            ok = channel.sendLine("OK");
+        } else if (command == "FOUND") {
+            long long leaseId = 0;
+            std::string password;
+            request >> leaseId >> password;
+            // Never end the search on a worker's word alone
+            if (simpleHash(password) != searchState.targetHash) {
+                std::lock_guard<std::mutex> lock(perfMetrics.outputMutex);
+                std::cout << "[Worker " << owner << "] Rejected FOUND \"" << password
+                          << "\" (lease " << leaseId << "): hash does not match" << std::endl;
+                ok = channel.sendLine("ERROR hash mismatch");
+            } else {
+                table.reportFound(password);
+                {
+                    std::lock_guard<std::mutex> lock(perfMetrics.outputMutex);
+                    std::cout << "[Worker " << owner << "] FOUND PASSWORD: \"" << password
+                              << "\" (lease " << leaseId << ")" << std::endl;
+                }
+                ok = channel.sendLine("OK");
+            }
+        } else {
+            ok = channel.sendLine("ERROR unknown command");
+        }
+        
+        if (!ok) {
+            break;
+        }
+    }
+    
+    // Anything this worker still held goes back to the pool
+    table.releaseOwner(owner);
+    shared.openConnections.fetch_sub(1);
+    
+    std::lock_guard<std::mutex> lock(perfMetrics.outputMutex);
+    std::cout << "[Worker " << owner << "] Disconnected" << std::endl;
+}
+
+/**
+ * Coordinator mode: own the key space and lease it to worker processes
+ */
+int runCoordinator(const std::string& bindAddress, int port, int maxLength,
+                   long long leaseSize, int leaseTimeoutSeconds) {
+    long long keySpaceSize = searchState.keySpaceSize;
+    
+    int listenFd = openListener(bindAddress, port);
+    if (listenFd < 0) {
+        std::cerr << "Error: could not listen on " << bindAddress << ":" << port << "\n";
+        return 1;
+    }
+    
+    std::cout << "Coordinator listening on " << bindAddress << ":" << port << "\n";
+    std::cout << "Key Space Size: " << keySpaceSize << " possible passwords (indices "
+              << searchState.rangeStart << " to " << searchState.rangeEnd << ")\n";
+    std::cout << "Lease Size: " << leaseSize << " candidates, timeout "
+              << leaseTimeoutSeconds << " seconds\n\n";
+    
+    LeaseTable table(searchState.rangeStart, searchState.rangeEnd, leaseSize,
+                     std::chrono::seconds(leaseTimeoutSeconds));
+    CoordinatorShared shared;
+    shared.table = &table;
+    shared.maxLength = maxLength;
+    
+    searchState.startTime = std::chrono::steady_clock::now();
+    
+    std::vector<std::thread> handlers;
+    int nextOwner = 0;
+    std::chrono::steady_clock::time_point finishedAt;
+    bool finished = false;
+    
+    // Accept workers until the search is over and they have all been told
+    // to stop (or a short grace period passes)
+    while (true) {
+        if (!finished && table.finished()) {
+            finished = true;
+            finishedAt = std::chrono::steady_clock::now();
+        }
+        if (finished && (shared.openConnections.load() == 0 ||
+                         std::chrono::steady_clock::now() - finishedAt > std::chrono::seconds(5))) {
+            break;
+        }
+        
+        pollfd pfd{listenFd, POLLIN, 0};
+        if (poll(&pfd, 1, 200) <= 0) {
+            continue;
+        }
+        int client = accept(listenFd, nullptr, nullptr);
+        if (client < 0) {
+            continue;
+        }
+        
+        int owner = nextOwner++;
+        shared.openConnections.fetch_add(1);
+        {
+            std::lock_guard<std::mutex> lock(perfMetrics.outputMutex);
+            std::cout << "[Worker " << owner << "] Connected" << std::endl;
+        }
+        handlers.emplace_back(serveRemoteWorker, client, owner, std::ref(shared));
+    }
+    
+    shared.shutdown.store(true);
+    for (auto& t : handlers) {
+        t.join();
+    }
+    close(listenFd);
+    
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - searchState.startTime).count();
+    
+    std::cout << "\n═══════════════════════════════════════════════════\n";
+    std::cout << "  COORDINATOR RESULTS\n";
+    std::cout << "═══════════════════════════════════════════════════\n";
+    if (table.isFound()) {
+        std::cout << "✓ Password FOUND: \"" << table.password() << "\"\n";
+    } else {
+        std::cout << "✗ Password NOT FOUND in searched key space\n";
+    }
+    std::cout << "\nPerformance Summary:\n";
+    std::cout << "  Total Attempts: " << searchState.totalAttempts.load() << "\n";
+    std::cout << "  Total Time: " << std::fixed << std::setprecision(3)
+              << (duration / 1000.0) << " seconds\n";
+    if (duration > 0) {
+        std::cout << "  Throughput: " << std::fixed << std::setprecision(2)
+                  << (searchState.totalAttempts.load() * 1000.0 / duration)
+                  << " attempts/sec\n";
+    }
+    std::cout << "  Re-leased Chunks: " << table.reclaimedCount() << "\n";
+    for (const auto& entry : shared.workers) {
+        std::cout << "  Worker " << entry.first << ": " << entry.second.attempts
+                  << " attempts in " << entry.second.chunks << " chunks ("
+                  << entry.second.threads << " threads)\n";
+    }
+    std::cout << "═══════════════════════════════════════════════════\n";
+    return 0;
+}
+
+// Work shared between a remote worker's network loop and its search threads
+struct LocalLeaseQueue {
+    struct Completion {
+        long long leaseId;
+        long long attempts;
+        bool found;
+    };
+    
+    std::mutex mutex;
+    std::condition_variable workAvailable;
+    std::condition_variable completionAvailable;
+    std::deque<Lease> leases;
+    std::deque<long long> started;     // lease ids picked up since the last report
+    std::deque<Completion> completions;
+    int busyThreads = 0;
+    int runningThreads = 0;
+    bool stop = false;
+};
+
+void leaseWorker(int threadId, LocalLeaseQueue& queue, int maxLength) {
+    auto threadStartTime = std::chrono::steady_clock::now();
+    applyWorkerPriority();
+    long long attempts = 0;
+    
+    while (true) {
+        Lease lease;
+        {
+            std::unique_lock<std::mutex> lock(queue.mutex);
+            queue.workAvailable.wait(lock, [&] { return queue.stop || !queue.leases.empty(); });
+            if (queue.leases.empty() || searchState.stopRequested.load()) {
+                break;
+            }
+            lease = queue.leases.front();
+            queue.leases.pop_front();
+            queue.started.push_back(lease.id);
+            queue.busyThreads++;
+        }
+        queue.completionAvailable.notify_one();
+        
+        long long before = attempts;
+        bool found = searchSlice(threadId, lease.start, lease.end, maxLength, attempts);
+        
+        {
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            queue.busyThreads--;
+            queue.completions.push_back({lease.id, attempts - before, found});
+        }
+        queue.completionAvailable.notify_one();
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.runningThreads--;
+    }
+    queue.completionAvailable.notify_one();
+    
+    recordThreadCompletion(threadId, attempts, threadStartTime);
+}
+
+/**
+ * Worker mode: pull chunk leases from a coordinator and search them locally
+ * 
+ * The network loop keeps up to two leases per thread queued locally, so a
+ * thread finishing a chunk starts the next one without a round trip.
+ */
+int runRemoteWorker(const std::string& coordinator, int numThreads) {
+    int fd = connectTo(coordinator);
+    if (fd < 0) {
+        std::cerr << "Error: could not connect to coordinator " << coordinator << "\n";
+        return 1;
+    }
+    LineChannel channel(fd);
+    
+    std::string reply;
+    if (!channel.sendLine("HELLO " + std::to_string(numThreads)) ||
+        channel.readLine(reply, 10000) != 1) {
+        std::cerr << "Error: coordinator did not answer HELLO\n";
+        return 1;
+    }
+    std::istringstream job(reply);
+    std::string command;
+    int maxLength = 0;
+    job >> command >> searchState.targetHash >> maxLength;
+    if (command != "JOB" || maxLength < 1) {
+        std::cerr << "Error: unexpected coordinator reply: " << reply << "\n";
+        return 1;
+    }
+    
+    std::cout << "Connected to coordinator " << coordinator << "\n";
+    std::cout << "Target Hash: " << searchState.targetHash << ", Maximum Length: "
+              << maxLength << ", Threads: " << numThreads << "\n\n";
+    
+    searchState.keySpaceSize = calculateKeySpace(maxLength);
+    searchState.startTime = std::chrono::steady_clock::now();
+    initTierStats(maxLength);
+    threadCounters.reset(new ThreadCounter[numThreads]);
+    threadCounterCount = numThreads;
+    
+    LocalLeaseQueue queue;
+    queue.runningThreads = numThreads;
+    std::vector<std::thread> threads;
+    for (int i = 0; i < numThreads; ++i) {
+        threads.emplace_back(leaseWorker, i, std::ref(queue), maxLength);
+    }
+    
+    const size_t prefetchDepth = static_cast<size_t>(numThreads) * 2;
+    bool stopRequested = false;
+    bool connectionLost = false;
+    bool failed = false;
+    auto waitUntil = std::chrono::steady_clock::now();
+    
+    while (true) {
+        std::deque<LocalLeaseQueue::Completion> completed;
+        std::deque<long long> started;
+        size_t outstanding;
+        int running;
+        {
+            std::unique_lock<std::mutex> lock(queue.mutex);
+            queue.completionAvailable.wait_for(lock, std::chrono::milliseconds(50), [&] {
+                return !queue.completions.empty() || !queue.started.empty() ||
+                       queue.runningThreads == 0 ||
+                       (!stopRequested && queue.leases.size() + queue.busyThreads < prefetchDepth &&
+                        std::chrono::steady_clock::now() >= waitUntil);
+            });
+            completed.swap(queue.completions);
+            started.swap(queue.started);
+            outstanding = queue.leases.size() + queue.busyThreads;
+            running = queue.runningThreads;
+        }
+        
+        // Report started and finished leases first so the coordinator's
+        // view (and its lease deadlines) stays fresh
+        for (long long leaseId : started) {
+            connectionLost |= !channel.sendLine("START " + std::to_string(leaseId)) ||
+                              channel.readLine(reply, 10000) != 1;
+        }
+        for (const auto& done : completed) {
+            if (done.found) {
+                std::string password;
+                {
+                    std::lock_guard<std::mutex> lock(searchState.resultMutex);
+                    password = searchState.foundPassword;
+                }
+                connectionLost |= !channel.sendLine("FOUND " + std::to_string(done.leaseId) +
+                                                    " " + password) ||
+                                  channel.readLine(reply, 10000) != 1;
+                stopRequested = true;
+            }
+            connectionLost |= !channel.sendLine("DONE " + std::to_string(done.leaseId) + " " +
+                                                std::to_string(done.attempts)) ||
+                              channel.readLine(reply, 10000) != 1;
+        }
+        
+        if (running == 0) {
+            break;
+        }
+        
+        if (!stopRequested && !connectionLost && outstanding < prefetchDepth &&
+            std::chrono::steady_clock::now() >= waitUntil) {
+            if (!channel.sendLine("LEASE") || channel.readLine(reply, 10000) != 1) {
+                connectionLost = true;
+            } else {
+                std::istringstream grant(reply);
+                grant >> command;
+                if (command == "CHUNK") {
+                    Lease lease;
+                    grant >> lease.id >> lease.start >> lease.end;
+                    {
+                        std::lock_guard<std::mutex> lock(queue.mutex);
+                        queue.leases.push_back(lease);
+                    }
+                    queue.workAvailable.notify_one();
+                } else if (command == "WAIT") {
+                    waitUntil = std::chrono::steady_clock::now() + std::chrono::milliseconds(200);
+                } else {
+                    std::string reason;
+                    grant >> reason;
+                    if (reason == "FOUND") {
+                        // Someone else cracked it: abandon in-flight chunks
+                        searchState.passwordFound.store(true);
+                        searchState.stopRequested.store(true);
+                    }
+                    stopRequested = true;
+                }
+            }
+        }
+        
+        if (connectionLost) {
+            if (!stopRequested) {
+                std::cerr << "Error: lost connection to coordinator\n";
+                failed = true;
+            }
+            searchState.stopRequested.store(true);
+            stopRequested = true;
+        }
+        
+        if (stopRequested) {
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (!queue.stop) {
+                queue.stop = true;
+                queue.workAvailable.notify_all();
+            }
+        }
+    }
+    
+    for (auto& t : threads) {
+        t.join();
+    }
+    
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - searchState.startTime).count();
+    std::cout << "\nWorker finished: " << searchState.totalAttempts.load()
+              << " attempts in " << std::fixed << std::setprecision(3)
+              << (duration / 1000.0) << " seconds\n";
+    return failed ? 1 : 0;
+}
+
+// Shared-memory cooperative mode: independent processes on one host sweep
+// one key space through a lock-free chunk dispenser in a POSIX segment
+const uint32_t SHM_MAGIC = 0x50435348;  // "PCSH"
+const int SHM_MAX_SLOTS = 1024;
+const int SHM_RECLAIMING = -1;          // slot pid while its chunk is being taken over
+
+struct SharedSlot {
+    std::atomic<int> pid;               // 0 = free, >0 = owning process
+    std::atomic<long long> chunk;       // chunk being searched, -1 = none
+};
+
+struct SharedSearchSegment {
+    std::atomic<uint32_t> magic;        // published last by the creator
+    uint32_t targetHash;
+    int maxLength;
+    long long rangeStart;
+    long long rangeEnd;
+    long long chunkSize;
+    long long totalChunks;
+    std::atomic<long long> nextChunk;
+    std::atomic<long long> chunksCompleted;
+    std::atomic<long long> totalAttempts;
+    std::atomic<int> foundState;        // 0 = none, 1 = writing, 2 = published
+    char foundPassword[64];
+    SharedSlot slots[SHM_MAX_SLOTS];
+};
+
+static_assert(std::atomic<long long>::is_always_lock_free &&
+              std::atomic<int>::is_always_lock_free,
+              "shared-memory mode needs address-free atomics");
+
+bool processAlive(int pid) {
+    return pid > 0 && (kill(pid, 0) == 0 || errno == EPERM);
+}
+
+/**
+ * Claim a free slot, or one left behind idle by a dead process
+ * 
+ * @return slot index, or -1 if the table is full
+ */
+int claimSharedSlot(SharedSearchSegment* segment) {
+    int self = static_cast<int>(getpid());
+    for (int i = 0; i < SHM_MAX_SLOTS; ++i) {
+        SharedSlot& slot = segment->slots[i];
+        int pid = slot.pid.load();
+        if (pid == 0 || (pid > 0 && !processAlive(pid) && slot.chunk.load() < 0)) {
+            if (slot.pid.compare_exchange_strong(pid, self)) {
+                slot.chunk.store(-1);
+                return i;
+            }
+        }
+    }
+    return -1;
+}
+
+/**
+ * Take the next unsearched chunk for `mine`
+ * 
+ * The chunk is recorded in the slot *before* the dispenser is advanced, so
+ * a process killed in between leaves at worst a duplicate, never a gap.
+ * Once the dispenser is exhausted, chunks held by dead processes are taken
+ * over.
+ * 
+ * @return chunk number, -1 when nothing is left, -2 when other live
+ *         processes still hold chunks (retry later in case they die)
+ */
+long long nextSharedChunk(SharedSearchSegment* segment, SharedSlot& mine, bool& reclaimed) {
+    reclaimed = false;
+    long long next = segment->nextChunk.load();
+    while (next < segment->totalChunks) {
+        mine.chunk.store(next);
+        if (segment->nextChunk.compare_exchange_weak(next, next + 1)) {
+            return next;
+        }
+    }
+    
+    bool othersBusy = false;
+    for (int i = 0; i < SHM_MAX_SLOTS; ++i) {
+        SharedSlot& slot = segment->slots[i];
+        if (&slot == &mine) {
+            continue;
+        }
+        int pid = slot.pid.load();
+        if (pid == 0 || slot.chunk.load() < 0) {
+            continue;
+        }
+        if (pid == SHM_RECLAIMING || processAlive(pid)) {
+            othersBusy = true;
+            continue;
+        }
+        if (slot.pid.compare_exchange_strong(pid, SHM_RECLAIMING)) {
+            long long chunk = slot.chunk.load();
+            mine.chunk.store(chunk);
+            slot.chunk.store(-1);
+            slot.pid.store(0);
+            if (chunk >= 0) {
+                reclaimed = true;
+                return chunk;
+            }
+        }
+    }
+    mine.chunk.store(-1);
+    return othersBusy ? -2 : -1;
+}
+
+void publishSharedFound(SharedSearchSegment* segment, const std::string& password) {
+    int expected = 0;
+    if (segment->foundState.compare_exchange_strong(expected, 1)) {
+        size_t length = std::min(password.size(), sizeof(segment->foundPassword) - 1);
+        std::memcpy(segment->foundPassword, password.data(), length);
+        segment->foundPassword[length] = '\0';
+        segment->foundState.store(2);
+    }
+}
+
+void sharedMemoryWorker(int threadId, SharedSearchSegment* segment, int slotIndex) {
+    auto threadStartTime = std::chrono::steady_clock::now();
+    applyWorkerPriority();
+    SharedSlot& mine = segment->slots[slotIndex];
+    long long attempts = 0;
+    
+    while (!searchState.stopRequested.load()) {
+        bool reclaimed = false;
+        long long chunk = nextSharedChunk(segment, mine, reclaimed);
+        if (chunk == -1) {
+            break;
+        }
+        if (chunk == -2) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            continue;
+        }
+        if (reclaimed) {
+            std::lock_guard<std::mutex> lock(perfMetrics.outputMutex);
+            std::cout << "[Thread " << threadId << "] Took over chunk " << chunk
+                      << " from a terminated process" << std::endl;
+        }
+        
+        long long start = segment->rangeStart + chunk * segment->chunkSize;
+        long long end = std::min(segment->rangeEnd, start + segment->chunkSize);
+        long long before = attempts;
+        if (searchSlice(threadId, start, end, segment->maxLength, attempts)) {
+            std::lock_guard<std::mutex> lock(searchState.resultMutex);
+            publishSharedFound(segment, searchState.foundPassword);
+        }
+        
+        segment->totalAttempts.fetch_add(attempts - before);
+        segment->chunksCompleted.fetch_add(1);
+        mine.chunk.store(-1);
+    }
+    
+    recordThreadCompletion(threadId, attempts, threadStartTime);
+}
+
+/**
+ * Attach to (or create) the named segment and sweep it cooperatively
+ * 
+ * Processes can join at any time and simply start taking chunks; chunks of
+ * a process that dies are picked up by the survivors once the dispenser
+ * runs dry. A segment describing a different search (often a stale one
+ * left behind by an earlier run) is only joined with `adopt` set, i.e.
+ * --shm-join; otherwise it is an error.
+ */
+int runSharedMemoryMode(const std::string& name, bool adopt, int numThreads, int maxLength,
+                        long long chunkSize, const std::string& logPath,
+                        const std::string& jsonPath) {
+    std::string shmName = name[0] == '/' ? name : "/" + name;
+    bool created = !adopt;
+    int fd = adopt ? shm_open(shmName.c_str(), O_RDWR, 0600)
+                   : shm_open(shmName.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (!adopt && fd < 0 && errno == EEXIST) {
+        created = false;
+        fd = shm_open(shmName.c_str(), O_RDWR, 0600);
+    }
+    if (fd < 0 || (created && ftruncate(fd, sizeof(SharedSearchSegment)) != 0)) {
+        std::cerr << "Error: could not open shared memory segment " << shmName << ": "
+                  << std::strerror(errno) << "\n";
+        return 1;
+    }
+    
+    // A joiner may race the creator's ftruncate; wait until the size is right
+    struct stat info{};
+    for (int i = 0; i < 100 && fstat(fd, &info) == 0 &&
+                    info.st_size < static_cast<off_t>(sizeof(SharedSearchSegment)); ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    
+    void* memory = mmap(nullptr, sizeof(SharedSearchSegment), PROT_READ | PROT_WRITE,
+                        MAP_SHARED, fd, 0);
+    close(fd);
+    if (memory == MAP_FAILED) {
+        std::cerr << "Error: could not map shared memory segment " << shmName << "\n";
+        return 1;
+    }
+    auto* segment = static_cast<SharedSearchSegment*>(memory);
+    
+    if (created) {
+        new (segment) SharedSearchSegment();
+        segment->targetHash = searchState.targetHash;
+        segment->maxLength = maxLength;
+        segment->rangeStart = searchState.rangeStart;
+        segment->rangeEnd = searchState.rangeEnd;
+        segment->chunkSize = chunkSize;
+        segment->totalChunks = (searchState.keySpaceSize + chunkSize - 1) / chunkSize;
+        segment->nextChunk.store(0);
+        segment->chunksCompleted.store(0);
+        segment->totalAttempts.store(0);
+        segment->foundState.store(0);
+        for (auto& slot : segment->slots) {
+            slot.pid.store(0);
+            slot.chunk.store(-1);
+        }
+        segment->magic.store(SHM_MAGIC);
+    } else {
+        for (int i = 0; i < 250 && segment->magic.load() != SHM_MAGIC; ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        }
+        if (segment->magic.load() != SHM_MAGIC) {
+            std::cerr << "Error: shared memory segment " << shmName << " was never initialised\n";
+            munmap(memory, sizeof(SharedSearchSegment));
+            return 1;
+        }
+        if (!adopt && (segment->targetHash != searchState.targetHash ||
+                       segment->maxLength != maxLength ||
+                       segment->rangeStart != searchState.rangeStart ||
+                       segment->rangeEnd != searchState.rangeEnd)) {
+            std::cerr << "Error: shared memory segment " << shmName << " holds a different search"
+                      << " (target hash " << segment->targetHash << ", max length "
+                      << segment->maxLength << "); use --shm-join " << name
+                      << " to join it, or remove /dev/shm" << shmName << " if it is stale\n";
+            munmap(memory, sizeof(SharedSearchSegment));
+            return 1;
+        }
+        // The segment defines the job; local arguments only pick the thread count
+        searchState.targetHash = segment->targetHash;
+        searchState.rangeStart = segment->rangeStart;
+        searchState.rangeEnd = segment->rangeEnd;
+        searchState.keySpaceSize = segment->rangeEnd - segment->rangeStart;
+        maxLength = segment->maxLength;
+    }
+    
+    std::cout << (created ? "Created" : "Attached to") << " shared search " << shmName
+              << " (pid " << getpid() << ")\n";
+    std::cout << "Key Space: indices " << segment->rangeStart << " to " << segment->rangeEnd
+              << " in " << segment->totalChunks << " chunks of " << segment->chunkSize << "\n";
+    std::cout << "Threads: " << numThreads << "\n\n";
+    
+    std::vector<int> slotIndices;
+    for (int i = 0; i < numThreads; ++i) {
+        int slot = claimSharedSlot(segment);
+        if (slot < 0) {
+            std::cerr << "Warning: shared slot table full, running with "
+                      << slotIndices.size() << " threads\n";
+            break;
+        }
+        slotIndices.push_back(slot);
+    }
+    numThreads = static_cast<int>(slotIndices.size());
+    initTierStats(maxLength);
+    
+    searchState.startTime = std::chrono::steady_clock::now();
+    threadCounters.reset(new ThreadCounter[std::max(1, numThreads)]);
+    threadCounterCount = numThreads;
+    
+    // Mirror a result published by any process into the local stop flag, so
+    // the search loop itself never reads shared memory
+    std::atomic<bool> workersDone{false};
+    std::thread monitor([&] {
+        while (!workersDone.load()) {
+            if (segment->foundState.load() == 2 && !searchState.passwordFound.load()) {
+                std::lock_guard<std::mutex> lock(searchState.resultMutex);
+                searchState.foundPassword = segment->foundPassword;
+                searchState.passwordFound.store(true);
+                searchState.stopRequested.store(true);
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    });
+    
+    std::vector<std::thread> threads;
+    for (int i = 0; i < numThreads; ++i) {
+        threads.emplace_back(sharedMemoryWorker, i, segment, slotIndices[i]);
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    workersDone.store(true);
+    monitor.join();
+    
+    for (int slot : slotIndices) {
+        segment->slots[slot].chunk.store(-1);
+        segment->slots[slot].pid.store(0);
+    }
+    
+    bool found = segment->foundState.load() == 2;
+    if (found) {
+        searchState.foundPassword = segment->foundPassword;
+        searchState.passwordFound.store(true);
+    }
+    long long sharedAttempts = segment->totalAttempts.load();
+    long long completed = segment->chunksCompleted.load();
+    long long totalChunks = segment->totalChunks;
+    
+    // Workers only stop once nothing is left anywhere (or a result is out),
+    // so the search is over for everyone: retire the name. Processes still
+    // attached keep their mapping until they exit.
+    shm_unlink(shmName.c_str());
+    munmap(memory, sizeof(SharedSearchSegment));
+    
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - searchState.startTime).count();
+    
+    std::cout << "\n═══════════════════════════════════════════════════\n";
+    std::cout << "  SHARED SEARCH RESULTS\n";
+    std::cout << "═══════════════════════════════════════════════════\n";
+    if (found) {
+        std::cout << "✓ Password FOUND: \"" << searchState.foundPassword << "\"\n";
+    } else {
+        std::cout << "✗ Password NOT FOUND in searched key space\n";
+    }
+    std::cout << "\nPerformance Summary:\n";
+    std::cout << "  This Process: " << searchState.totalAttempts.load() << " attempts in "
+              << std::fixed << std::setprecision(3) << (duration / 1000.0) << " seconds\n";
+    std::cout << "  All Processes: " << sharedAttempts << " attempts, " << completed
+              << " of " << totalChunks << " chunks\n";
+    
+    logPerformanceMetrics(logPath);
+    std::cout << "\nDetailed metrics saved to: " << logPath << "\n";
+    if (!jsonPath.empty()) {
+        writeJsonReport(jsonPath);
+        std::cout << "JSON report saved to: " << jsonPath << "\n";
+    }
+    std::cout << "═══════════════════════════════════════════════════\n";
+    return 0;
+}
+
+/**
+ * One brute-force job submitted to the daemon
+ * 
+ * Jobs carry their own targets, stop flag and counters, so several can
+ * share the warm worker pool without touching the global searchState.
+ */
+struct DaemonJob {
+    long long id = 0;
+    int maxLength = 0;
+    long long fullKeySpace = 0;             // calculateKeySpace(maxLength)
+    long long keySpace = 0;                 // indices to search: fullKeySpace capped by the budget
+    std::chrono::steady_clock::time_point startTime;
+    std::chrono::steady_clock::time_point deadline;
+    std::vector<uint32_t> targets;          // sorted, unique
+    std::vector<char> targetFound;          // guarded by resultMutex
+    std::mutex resultMutex;
+    std::atomic<int> remaining{0};
+    std::atomic<long long> nextIndex{0};
+    std::atomic<long long> attempts{0};
+    std::atomic<bool> stop{false};
+    std::atomic<bool> cancelled{false};     // client went away
+    int inFlight = 0;                       // guarded by the scheduler mutex
+    
+    // Lines streamed back to the submitting client
+    std::mutex eventMutex;
+    std::condition_variable eventReady;
+    std::deque<std::string> events;
+    
+    void post(const std::string& line) {
+        {
+            std::lock_guard<std::mutex> lock(eventMutex);
+            events.push_back(line);
+        }
+        eventReady.notify_all();
+    }
+};
+
+/**
+ * Shared worker pool for daemon jobs
+ * 
+ * Threads take one chunk at a time from the active jobs in round-robin
+ * order, so concurrent jobs get an equal share of the pool regardless of
+ * their size.
+ */
+class JobScheduler {
+public:
+    static constexpr long long CHUNK_SIZE = 1000000;
+    
+    void start(int numThreads) {
+        threadCounters.reset(new ThreadCounter[numThreads]);
+        threadCounterCount = numThreads;
+        for (int i = 0; i < numThreads; ++i) {
+            pool.emplace_back(&JobScheduler::workerLoop, this, i);
+        }
+    }
+    
+    void shutdown() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            shuttingDown = true;
+            for (auto& job : active) {
+                job->stop.store(true);
+            }
+        }
+        workReady.notify_all();
+        for (auto& t : pool) {
+            t.join();
+        }
+        pool.clear();
+    }
+    
+    void submit(const std::shared_ptr<DaemonJob>& job) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            active.push_back(job);
+        }
+        workReady.notify_all();
+    }
+    
+    std::vector<std::shared_ptr<DaemonJob>> snapshot() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return active;
+    }
+    
+private:
+    bool takeChunk(std::shared_ptr<DaemonJob>& job, long long& start, long long& end) {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            if (shuttingDown) {
+                return false;
+            }
+            
+            auto now = std::chrono::steady_clock::now();
+            size_t count = active.size();
+            for (size_t n = 0; n < count; ++n) {
+                size_t index = (cursor + n) % count;
+                auto& candidate = active[index];
+                if (now >= candidate->deadline) {
+                    candidate->stop.store(true);
+                }
+                long long next = candidate->nextIndex.load();
+                if (candidate->stop.load() || next >= candidate->keySpace) {
+                    continue;
+                }
+                start = next;
+                end = std::min(candidate->keySpace, next + CHUNK_SIZE);
+                candidate->nextIndex.store(end);
+                candidate->inFlight++;
+                job = candidate;
+                cursor = index + 1;
+                return true;
+            }
+            
+            retireFinishedLocked();
+            workReady.wait_for(lock, std::chrono::milliseconds(100));
+        }
+    }
+    
+    void chunkDone(const std::shared_ptr<DaemonJob>& job) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            job->inFlight--;
+            retireFinishedLocked();
+        }
+        workReady.notify_all();
+    }
+    
+    void retireFinishedLocked() {
+        for (auto it = active.begin(); it != active.end();) {
+            auto& job = *it;
+            long long next = job->nextIndex.load();
+            bool drained = next >= job->keySpace;
+            if ((drained || job->stop.load()) && job->inFlight == 0) {
+                // Running out of a candidate budget drains the job too, but
+                // only the whole key space counts as exhausted
+                std::string status = job->remaining.load() == 0 ? "all-found"
+                                   : next >= job->fullKeySpace ? "exhausted"
+                                   : shuttingDown || job->cancelled.load() ? "cancelled" : "budget";
+                double seconds = std::chrono::duration<double>(
+                    std::chrono::steady_clock::now() - job->startTime).count();
+                std::ostringstream line;
+                line << "DONE " << job->id << " " << status << " " << job->attempts.load()
+                     << " " << std::fixed << std::setprecision(3) << seconds;
+                job->post(line.str());
+                it = active.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        if (cursor >= active.size()) {
+            cursor = 0;
+        }
+    }
+    
+    /**
+     * Same source and batched hasher as CandidatePipeline, with candidate
+     * buffers reused across chunks and jobs; each hash is looked up in the
+     * job's sorted target list instead of compared with one target
+     */
+    void workerLoop(int threadId) {
+        static const int BATCH = 64;
+        std::string batch[BATCH];
+        uint32_t hashes[BATCH];
+        SimpleHasher hasher;
+        long long attempts = 0;
+        std::shared_ptr<DaemonJob> job;
+        long long start, end;
+        
+        while (takeChunk(job, start, end)) {
+            long long before = attempts;
+            BruteForceSource source{job->maxLength};
+            for (long long i = start; i < end && !job->stop.load(std::memory_order_relaxed);) {
+                int count = static_cast<int>(std::min<long long>(BATCH, end - i));
+                for (int k = 0; k < count; ++k) {
+                    source.generate(i + k, batch[k]);
+                }
+                hasher.hashBatch(batch, count, hashes);
+                i += count;
+                attempts += count;
+                
+                for (int k = 0; k < count; ++k) {
+                    auto match = std::lower_bound(job->targets.begin(), job->targets.end(), hashes[k]);
+                    if (match == job->targets.end() || *match != hashes[k]) {
+                        continue;
+                    }
+                    size_t slot = match - job->targets.begin();
+                    std::lock_guard<std::mutex> lock(job->resultMutex);
+                    if (!job->targetFound[slot]) {
+                        job->targetFound[slot] = 1;
+                        job->post("FOUND " + std::to_string(job->id) + " " +
+                                  std::to_string(hashes[k]) + " " + batch[k]);
+                        if (job->remaining.fetch_sub(1) == 1) {
+                            // Nothing left to find: the rest of the batch was never needed
+                            job->stop.store(true);
+                            attempts -= count - 1 - k;
+                            break;
+                        }
+                    }
+                }
+            }
+            job->attempts.fetch_add(attempts - before);
+            threadCounters[threadId].attempts.store(attempts, std::memory_order_relaxed);
+            chunkDone(job);
+            job.reset();
+        }
+    }
+    
+    std::mutex mutex;
+    std::condition_variable workReady;
+    std::vector<std::shared_ptr<DaemonJob>> active;
+    size_t cursor = 0;
+    bool shuttingDown = false;
+    std::vector<std::thread> pool;
+};
+
+int openUnixListener(const std::string& path) {
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path)) {
+        close(fd);
+        return -1;
+    }
+    std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+    unlink(path.c_str());
+    if (bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 || listen(fd, 16) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int connectUnix(const std::string& path) {
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+    if (connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/**
+ * Serve one client connection on the daemon socket
+ * 
+ * Protocol:
+ *   SUBMIT <mode> <maxLength> <budgetSeconds> <budgetCandidates> <hash>[,<hash>...]
+ *       -> ACCEPTED <id>, then FOUND <id> <hash> <password> per hit,
+ *          then DONE <id> <all-found|exhausted|budget> <attempts> <seconds>
+ *   STATUS   -> JOB <id> <attempts> <keySpace> <remaining> per active job, then END
+ *   SHUTDOWN -> OK, and the daemon exits once running jobs are cancelled
+ * 
+ * A budget of 0 means unlimited.
+ */
+void serveDaemonClient(int fd, JobScheduler& scheduler, std::atomic<long long>& nextJobId,
+                       std::atomic<bool>& shutdownRequested) {
+    LineChannel channel(fd);
+    std::string line;
+    
+    while (!shutdownRequested.load()) {
+        int status = channel.readLine(line, 500);
+        if (status == 0) {
+            continue;
+        }
+        if (status < 0) {
+            return;
+        }
+        
+        std::istringstream request(line);
+        std::string command;
+        request >> command;
+        
+        if (command == "SUBMIT") {
+            std::string mode, hashList;
+            int maxLength = 0;
+            double budgetSeconds = 0;
+            long long budgetCandidates = 0;
+            request >> mode >> maxLength >> budgetSeconds >> budgetCandidates >> hashList;
+            if (mode != "bruteforce" || maxLength < 1 || maxLength > 8 || hashList.empty()) {
+                channel.sendLine("ERROR expected SUBMIT bruteforce <1-8> <seconds> <candidates> <hashes>");
+                continue;
+            }
+            
+            auto job = std::make_shared<DaemonJob>();
+            job->id = nextJobId.fetch_add(1);
+            job->maxLength = maxLength;
+            job->fullKeySpace = calculateKeySpace(maxLength);
+            job->keySpace = job->fullKeySpace;
+            if (budgetCandidates > 0) {
+                job->keySpace = std::min(job->keySpace, budgetCandidates);
+            }
+            job->startTime = std::chrono::steady_clock::now();
+            job->deadline = budgetSeconds > 0
+                ? job->startTime + std::chrono::milliseconds(static_cast<long long>(budgetSeconds * 1000))
+                : std::chrono::steady_clock::time_point::max();
+            
+            std::istringstream hashes(hashList);
+            std::string token;
+            bool validHashes = true;
+            while (std::getline(hashes, token, ',')) {
+                if (token.empty()) {
+                    continue;
+                }
+                char* end = nullptr;
+                errno = 0;
+                unsigned long long hash = std::isdigit(static_cast<unsigned char>(token[0]))
+                    ? std::strtoull(token.c_str(), &end, 10) : 0;
+                if (end == nullptr || *end != '\0' || errno == ERANGE ||
+                    hash > std::numeric_limits<uint32_t>::max()) {
+                    validHashes = false;
+                    break;
+                }
+                job->targets.push_back(static_cast<uint32_t>(hash));
+            }
+            if (!validHashes || job->targets.empty()) {
+                channel.sendLine("ERROR bad hash list: expected comma-separated 32-bit decimal hashes");
+                continue;
+            }
+            std::sort(job->targets.begin(), job->targets.end());
+            job->targets.erase(std::unique(job->targets.begin(), job->targets.end()),
+                               job->targets.end());
+            job->targetFound.assign(job->targets.size(), 0);
+            job->remaining.store(static_cast<int>(job->targets.size()));
+            
+            channel.sendLine("ACCEPTED " + std::to_string(job->id));
+            scheduler.submit(job);
+            
+            // Stream this job's events until it is done
+            bool done = false;
+            while (!done) {
+                std::deque<std::string> pending;
+                {
+                    std::unique_lock<std::mutex> lock(job->eventMutex);
+                    job->eventReady.wait(lock, [&] { return !job->events.empty(); });
+                    pending.swap(job->events);
+                }
+                for (const auto& event : pending) {
+                    if (!channel.sendLine(event)) {
+                        job->cancelled.store(true);  // client went away: cancel its job
+                        job->stop.store(true);
+                        return;
+                    }
+                    done |= event.rfind("DONE ", 0) == 0;
+                }
+            }
+        } else if (command == "STATUS") {
+            for (const auto& job : scheduler.snapshot()) {
+                channel.sendLine("JOB " + std::to_string(job->id) + " " +
+                                 std::to_string(job->attempts.load()) + " " +
+                                 std::to_string(job->keySpace) + " " +
+                                 std::to_string(job->remaining.load()));
+            }
+            channel.sendLine("END");
+        } else if (command == "SHUTDOWN") {
+            shutdownRequested.store(true);
+            channel.sendLine("OK");
+            return;
+        } else {
+            channel.sendLine("ERROR unknown command");
+        }
+    }
+}
+
+/**
+ * Daemon mode: keep a worker pool warm and run jobs submitted over a
+ * Unix domain socket
+ */
+int runJobDaemon(const std::string& socketPath, int numThreads) {
+    int listenFd = openUnixListener(socketPath);
+    if (listenFd < 0) {
+        std::cerr << "Error: could not listen on " << socketPath << "\n";
+        return 1;
+    }
+    
+    JobScheduler scheduler;
+    scheduler.start(numThreads);
+    searchState.startTime = std::chrono::steady_clock::now();
+    std::cout << "Job daemon listening on " << socketPath << " with "
+              << numThreads << " worker threads\n";
+    
+    std::atomic<long long> nextJobId{1};
+    std::atomic<bool> shutdownRequested{false};
+    std::vector<std::thread> clients;
+    
+    while (!shutdownRequested.load()) {
+        pollfd pfd{listenFd, POLLIN, 0};
+        if (poll(&pfd, 1, 200) <= 0) {
+            continue;
+        }
+        int client = accept(listenFd, nullptr, nullptr);
+        if (client >= 0) {
+            clients.emplace_back(serveDaemonClient, client, std::ref(scheduler),
+                                 std::ref(nextJobId), std::ref(shutdownRequested));
+        }
+    }
+    
+    // Cancelling the pool posts DONE for every running job, which lets the
+    // streaming client handlers return
+    scheduler.shutdown();
+    for (auto& job : scheduler.snapshot()) {
+        job->post("DONE " + std::to_string(job->id) + " cancelled " +
+                  std::to_string(job->attempts.load()) + " 0");
+    }
+    for (auto& t : clients) {
+        t.join();
+    }
+    close(listenFd);
+    unlink(socketPath.c_str());
+    std::cout << "Job daemon stopped\n";
+    return 0;
+}
+
+/**
+ * `submit` subcommand: send one job to a running daemon and print its
+ * results as they stream back
+ * 
+ * Usage: submit <socket> <target[,target...]> [maxLength]
+ *               [--budget-seconds S] [--budget-candidates N]
+ *        submit <socket> --status | --shutdown
+ */
+int runJobClient(int argc, char* argv[]) {
+    std::vector<std::string> positional;
+    double budgetSeconds = 0;
+    long long budgetCandidates = 0;
+    std::string control;
+    for (int i = 2; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--status" || arg == "--shutdown") {
+            control = arg == "--status" ? "STATUS" : "SHUTDOWN";
+        } else if (arg == "--budget-seconds" && i + 1 < argc) {
+            budgetSeconds = std::stod(argv[++i]);
+        } else if (arg == "--budget-candidates" && i + 1 < argc) {
+            budgetCandidates = std::stoll(argv[++i]);
+        } else {
+            positional.push_back(arg);
+        }
+    }
+    if (positional.empty() || (control.empty() && positional.size() < 2)) {
+        std::cerr << "Usage: " << argv[0] << " submit <socket> <target[,target...]> [maxLength]"
+                  << " [--budget-seconds S] [--budget-candidates N]\n"
+                  << "       " << argv[0] << " submit <socket> --status | --shutdown\n";
+        return 1;
+    }
+    
+    int fd = connectUnix(positional[0]);
+    if (fd < 0) {
+        std::cerr << "Error: could not connect to daemon at " << positional[0] << "\n";
+        return 1;
+    }
+    LineChannel channel(fd);
+    std::string line;
+    
+    if (!control.empty()) {
+        channel.sendLine(control);
+        while (channel.readLine(line, 10000) == 1) {
+            std::cout << line << "\n";
+            if (line == "END" || line == "OK") {
+                return 0;
+            }
+        }
+        return 1;
+    }
+    
+    int maxLength = positional.size() >= 3 ? std::stoi(positional[2]) : 4;
+    
+    std::string hashList;
+    std::istringstream targets(positional[1]);
+    std::string target;
+    while (std::getline(targets, target, ',')) {
+        if (!hashList.empty()) {
+            hashList += ",";
+        }
+        hashList += std::to_string(simpleHash(target));
+    }
+    
+    std::ostringstream request;
+    request << "SUBMIT bruteforce " << maxLength << " " << budgetSeconds << " "
+            << budgetCandidates << " " << hashList;
+    if (!channel.sendLine(request.str())) {
+        std::cerr << "Error: daemon closed the connection\n";
+        return 1;
+    }
+    
+    while (channel.readLine(line, 60000) >= 0) {
+        if (line.rfind("ERROR", 0) == 0) {
+            std::cerr << line << "\n";
+            return 1;
+        }
+        std::cout << line << std::endl;
+        if (line.rfind("DONE ", 0) == 0) {
+            return 0;
+        }
+    }
+    std::cerr << "Error: daemon closed the connection\n";
+    return 1;
+}
+
+/**
+ * How many CPUs this process may actually use
+ * 
+ * hardware_concurrency() reports every CPU on the host, which oversubscribes
+ * containers limited by an affinity mask or a CFS quota.
+ */
+struct CpuBudget {
+    int affinityCpus = 0;      // CPUs in the sched_getaffinity() mask
+    int physicalCores = 0;     // distinct SMT sibling groups in that mask
+    double quotaCpus = -1.0;   // cgroup CPU quota in CPUs, -1 = unlimited
+    int threads = 0;           // recommended worker count
+};
+
+std::string readFirstLine(const std::string& path) {
+    std::ifstream file(path);
+    std::string line;
+    std::getline(file, line);
+    return line;
+}
+
+// A cgroup filesystem mount from /proc/self/mountinfo
+struct CgroupMount {
+    std::string root;          // cgroup path mounted at `mountPoint`
+    std::string mountPoint;
+    bool unified = false;      // cgroup2, otherwise a v1 hierarchy with the cpu controller
+};
+
+// mountinfo escapes space, tab, newline and backslash as \ooo
+std::string unescapeMountField(const std::string& field) {
+    std::string out;
+    for (size_t i = 0; i < field.size(); ++i) {
+        auto octal = [&](size_t k) { return field[k] >= '0' && field[k] <= '7'; };
+        if (field[i] == '\\' && i + 3 < field.size() && octal(i + 1) && octal(i + 2) && octal(i + 3)) {
+            out += static_cast<char>((field[i + 1] - '0') * 64 + (field[i + 2] - '0') * 8 +
+                                     (field[i + 3] - '0'));
+            i += 3;
+        } else {
+            out += field[i];
+        }
+    }
+    return out;
+}
+
+/**
+ * cgroup2 mounts and v1 mounts carrying the cpu controller
+ * 
+ * Line format: id parent major:minor root mount-point options
+ * [optional fields...] - fstype source super-options
+ */
+std::vector<CgroupMount> readCgroupMounts() {
+    std::vector<CgroupMount> mounts;
+    std::ifstream mountinfo("/proc/self/mountinfo");
+    std::string line;
+    while (std::getline(mountinfo, line)) {
+        std::istringstream fields(line);
+        std::string id, parent, device, root, mountPoint, field;
+        fields >> id >> parent >> device >> root >> mountPoint;
+        while (fields >> field && field != "-") {
+        }
+        std::string type, source, options;
+        fields >> type >> source >> options;
+        
+        CgroupMount mount;
+        mount.root = unescapeMountField(root);
+        mount.mountPoint = unescapeMountField(mountPoint);
+        mount.unified = type == "cgroup2";
+        bool cpuV1 = false;
+        std::istringstream list(options);
+        std::string option;
+        while (type == "cgroup" && std::getline(list, option, ',')) {
+            cpuV1 |= option == "cpu";
+        }
+        if (mount.unified || cpuV1) {
+            mounts.push_back(mount);
+        }
+    }
+    return mounts;
+}
+
+/**
+ * Tightest cgroup CPU quota on the path from this process's cgroup to the
+ * root, checking the v2 unified hierarchy and the v1 cpu controller
+ * 
+ * The path in /proc/self/cgroup is relative to the hierarchy's root, which
+ * need not be what is mounted: a container typically sees only its own
+ * subtree. Each path is therefore resolved through /proc/self/mountinfo,
+ * whose mount root is stripped from the path before appending the rest to
+ * the mount point; the walk stops at the mount point. Without mountinfo
+ * the conventional /sys/fs/cgroup locations are tried instead.
+ * 
+ * @return quota in CPUs, or -1 when no limit is set or cgroups are absent
+ */
+double readCgroupCpuQuota() {
+    std::ifstream cgroups("/proc/self/cgroup");
+    std::vector<CgroupMount> mounts = readCgroupMounts();
+    std::string line;
+    double tightest = -1.0;
+    auto consider = [&](double quota) {
+        if (quota > 0 && (tightest < 0 || quota < tightest)) {
+            tightest = quota;
+        }
+    };
+    
+    // Quota files from `dir` up to (and including) `top`
+    auto walk = [&](std::string dir, const std::string& top, bool unified) {
+        while (true) {
+            if (unified) {
+                std::istringstream max(readFirstLine(dir + "/cpu.max"));
+                std::string quota;
+                double period = 0;
+                if (max >> quota >> period && quota != "max" && period > 0) {
+                    consider(std::stod(quota) / period);
+                }
+            } else {
+                std::string quota = readFirstLine(dir + "/cpu.cfs_quota_us");
+                std::string period = readFirstLine(dir + "/cpu.cfs_period_us");
+                if (!quota.empty() && !period.empty() && std::stoll(quota) > 0 &&
+                    std::stoll(period) > 0) {
+                    consider(static_cast<double>(std::stoll(quota)) / std::stoll(period));
+                }
+            }
+            if (dir.size() <= top.size()) {
+                break;
+            }
+            dir = dir.substr(0, dir.rfind('/'));
+        }
+    };
+    
+    while (std::getline(cgroups, line)) {
+        // Format: hierarchy-id:controller-list:path
+        size_t first = line.find(':');
+        size_t second = line.find(':', first + 1);
+        if (first == std::string::npos || second == std::string::npos) {
+            continue;
+        }
+        std::string controllers = line.substr(first + 1, second - first - 1);
+        std::string path = line.substr(second + 1);
+        
+        bool unified = controllers.empty();
+        bool cpuV1 = false;
+        std::istringstream list(controllers);
+        std::string controller;
+        while (std::getline(list, controller, ',')) {
+            cpuV1 |= controller == "cpu";
+        }
+        if (!unified && !cpuV1) {
+            continue;
+        }
+        
+        bool resolved = false;
+        for (const auto& mount : mounts) {
+            if (mount.unified != unified) {
+                continue;
+            }
+            // The mount root must be a whole-component prefix of the path
+            std::string root = mount.root == "/" ? "" : mount.root;
+            if (path.compare(0, root.size(), root) != 0 ||
+                (path.size() > root.size() && path[root.size()] != '/')) {
+                continue;
+            }
+            std::string rest = path.substr(root.size());
+            walk(mount.mountPoint + (rest == "/" ? "" : rest), mount.mountPoint, unified);
+            resolved = true;
+        }
+        if (resolved) {
+            continue;
+        }
+        
+        std::vector<std::string> roots = unified
+            ? std::vector<std::string>{"/sys/fs/cgroup", "/sys/fs/cgroup/unified"}
+            : std::vector<std::string>{"/sys/fs/cgroup/cpu", "/sys/fs/cgroup/cpu,cpuacct"};
+        for (const auto& root : roots) {
+            walk(root + (path == "/" ? "" : path), root, unified);
+        }
+    }
+    return tightest;
+}
+
+/**
+ * Work out a default thread count from the affinity mask, SMT topology
+ * and cgroup quota, falling back to hardware_concurrency() and then 4
+ */
+CpuBudget detectCpuBudget(bool excludeSmt) {
+    CpuBudget budget;
+    
+    cpu_set_t mask;
+    CPU_ZERO(&mask);
+    if (sched_getaffinity(0, sizeof(mask), &mask) == 0) {
+        budget.affinityCpus = CPU_COUNT(&mask);
+        
+        // Count each SMT sibling group once, keyed by its sibling list
+        std::vector<std::string> groups;
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+            if (!CPU_ISSET(cpu, &mask)) {
+                continue;
+            }
+            std::string siblings = readFirstLine("/sys/devices/system/cpu/cpu" +
+                                                 std::to_string(cpu) +
+                                                 "/topology/thread_siblings_list");
+            if (siblings.empty()) {
+                siblings = std::to_string(cpu);
+            }
+            if (std::find(groups.begin(), groups.end(), siblings) == groups.end()) {
+                groups.push_back(siblings);
+            }
+        }
+        budget.physicalCores = static_cast<int>(groups.size());
+    }
+    if (budget.affinityCpus <= 0) {
+        budget.affinityCpus = static_cast<int>(std::thread::hardware_concurrency());
+        budget.physicalCores = budget.affinityCpus;
+    }
+    
+    budget.quotaCpus = readCgroupCpuQuota();
+    
+    int threads = excludeSmt ? budget.physicalCores : budget.affinityCpus;
+    if (budget.quotaCpus > 0) {
+        int quotaThreads = std::max(1, static_cast<int>(std::ceil(budget.quotaCpus - 0.01)));
+        threads = threads > 0 ? std::min(threads, quotaThreads) : quotaThreads;
+    }
+    budget.threads = threads > 0 ? threads : 4;
+    return budget;
+}
+
+// Elastic local search: threads pull chunks from one dispenser, so the
+// pool can grow or shrink mid-search without re-partitioning
+const int ELASTIC_MAX_THREADS = 256;
+
+// Thread-count adjustments requested by SIGTTIN (+1) / SIGTTOU (-1)
+std::atomic<int> elasticSignalDelta{0};
+
+void handleElasticSignal(int signal) {
+    elasticSignalDelta.fetch_add(signal == SIGTTIN ? 1 : -1);
+}
+
+struct ElasticSlot {
+    std::thread thread;
+    std::atomic<bool> retire{false};
+    std::atomic<bool> exited{false};
+    bool inUse = false;
+};
+
+struct ElasticPool {
+    std::atomic<long long> nextIndex{0};
+    long long rangeEnd = 0;
+    long long chunkSize = 0;
+    int maxLength = 0;
+    ElasticSlot slots[ELASTIC_MAX_THREADS];
+    
+    bool workRemains() const {
+        return nextIndex.load() < rangeEnd && !searchState.stopRequested.load();
+    }
+};
+
+/**
+ * Elastic worker: search chunks until the dispenser is empty or the
+ * supervisor asks this thread to retire
+ * 
+ * Retirement is only honoured between chunks, so every chunk taken is
+ * searched completely and coverage stays exact.
+ */
+void elasticWorker(int threadId, ElasticPool& pool) {
+    auto threadStartTime = std::chrono::steady_clock::now();
+    applyWorkerPriority();
+    ElasticSlot& slot = pool.slots[threadId];
+    // A reused slot keeps counting from where its previous thread stopped
+    long long attempts = threadCounters[threadId].attempts.load();
+    long long initialAttempts = attempts;
+    
+    while (!slot.retire.load() && !searchState.stopRequested.load()) {
+        long long start = pool.nextIndex.fetch_add(pool.chunkSize);
+        if (start >= pool.rangeEnd) {
+            break;
+        }
+        long long end = std::min(pool.rangeEnd, start + pool.chunkSize);
+        long long before = attempts;
+        searchSlice(threadId, start, end, pool.maxLength, attempts);
+        if (searchState.interrupted.load()) {
+            recordUnfinished(start + (attempts - before), end);
+        }
+    }
+    
+    recordThreadCompletion(threadId, attempts - initialAttempts, threadStartTime);
+    slot.exited.store(true);
+}
+
+/**
+ * Sample how many CPUs processes other than this one keep busy
+ * 
+ * Uses /proc/stat for the machine and getrusage() for this process;
+ * returns a negative value until two samples are available.
+ */
+class ExternalLoadSampler {
+public:
+    double sample() {
+        std::ifstream stat("/proc/stat");
+        std::string cpu;
+        long long user = 0, nice = 0, system = 0, idle = 0, iowait = 0, irq = 0, softirq = 0, steal = 0;
+        stat >> cpu >> user >> nice >> system >> idle >> iowait >> irq >> softirq >> steal;
+        long long busy = user + nice + system + irq + softirq + steal;
+        long long total = busy + idle + iowait;
+        
+        rusage usage{};
+        getrusage(RUSAGE_SELF, &usage);
+        double ownSeconds = usage.ru_utime.tv_sec + usage.ru_stime.tv_sec +
+                            (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+        auto now = std::chrono::steady_clock::now();
+        
+        double external = -1.0;
+        if (lastTotal > 0 && total > lastTotal) {
+            long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+            double busyCpus = static_cast<double>(busy - lastBusy) / (total - lastTotal) * cpus;
+            double wall = std::chrono::duration<double>(now - lastTime).count();
+            double ownCpus = wall > 0 ? (ownSeconds - lastOwnSeconds) / wall : 0.0;
+            external = std::max(0.0, busyCpus - ownCpus);
+        }
+        
+        lastBusy = busy;
+        lastTotal = total;
+        lastOwnSeconds = ownSeconds;
+        lastTime = now;
+        return external;
+    }
+    
+private:
+    long long lastBusy = 0;
+    long long lastTotal = 0;
+    double lastOwnSeconds = 0;
+    std::chrono::steady_clock::time_point lastTime;
+};
+
+/**
+ * Run the local search with a resizable thread pool
+ * 
+ * The calling thread supervises: it applies SIGTTIN/SIGTTOU, commands on
+ * the optional control socket ("THREADS n", "THREADS +n", "THREADS -n",
+ * "PAUSE", "RESUME", "STATUS") and, with loadPolicy, backs off while other processes keep
+ * CPUs busy (never above the launch thread count).
+ */
+void runElasticSearch(int numThreads, int maxLength, long long chunkSize,
+                      const std::string& controlPath, bool loadPolicy) {
+    auto pool = std::make_unique<ElasticPool>();
+    pool->nextIndex.store(searchState.rangeStart);
+    pool->rangeEnd = searchState.rangeEnd;
+    pool->chunkSize = chunkSize;
+    pool->maxLength = maxLength;
+    
+    struct sigaction action{};
+    action.sa_handler = handleElasticSignal;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+    sigaction(SIGTTIN, &action, nullptr);
+    sigaction(SIGTTOU, &action, nullptr);
+    
+    int controlFd = -1;
+    if (!controlPath.empty()) {
+        controlFd = openUnixListener(controlPath);
+        if (controlFd < 0) {
+            std::cerr << "Warning: could not open control socket " << controlPath << "\n";
+        }
+    }
+    
+    int requested = std::min(numThreads, ELASTIC_MAX_THREADS);
+    int launchThreads = requested;
+    std::vector<int> running;
+    ExternalLoadSampler sampler;
+    auto nextLoadSample = std::chrono::steady_clock::now();
+    
+    auto announce = [&](int from, int to, const char* reason) {
+        double seconds = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - searchState.startTime).count();
+        std::lock_guard<std::mutex> lock(perfMetrics.outputMutex);
+        perfMetrics.threadTimeline.push_back({seconds, from, to, reason});
+        std::cout << "[Scheduler] Threads " << from << " -> " << to << " (" << reason << ")"
+                  << std::endl;
+    };
+    auto setRequested = [&](int value, const char* reason) {
+        value = std::max(1, std::min(ELASTIC_MAX_THREADS, value));
+        if (value != requested) {
+            announce(requested, value, reason);
+            requested = value;
+        }
+    };
+    
+    while (true) {
+        // Reap threads that finished or retired
+        for (int id = 0; id < ELASTIC_MAX_THREADS; ++id) {
+            ElasticSlot& slot = pool->slots[id];
+            if (slot.inUse && slot.exited.load()) {
+                slot.thread.join();
+                slot.inUse = false;
+                running.erase(std::remove(running.begin(), running.end(), id), running.end());
+            }
+        }
+        bool anyInUse = std::any_of(std::begin(pool->slots), std::end(pool->slots),
+                                    [](const ElasticSlot& slot) { return slot.inUse; });
+        if (!pool->workRemains() && !anyInUse) {
+            break;
+        }
+        
+        int delta = elasticSignalDelta.exchange(0);
+        if (delta != 0) {
+            setRequested(requested + delta, "signal");
+        }
+        
+        if (loadPolicy && std::chrono::steady_clock::now() >= nextLoadSample) {
+            nextLoadSample = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+            double external = sampler.sample();
+            if (external >= 0) {
+                long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+                int fits = static_cast<int>(std::floor(cpus - external + 0.5));
+                setRequested(std::min(launchThreads, fits), "load policy");
+            }
+        }
+        
+        // Grow: reuse the lowest free slot so per-thread ids stay compact
+        while (static_cast<int>(running.size()) < requested && pool->workRemains()) {
+            int id = 0;
+            while (id < ELASTIC_MAX_THREADS && pool->slots[id].inUse) {
+                id++;
+            }
+            if (id == ELASTIC_MAX_THREADS) {
+                break;
+            }
+            ElasticSlot& slot = pool->slots[id];
+            slot.retire.store(false);
+            slot.exited.store(false);
+            slot.inUse = true;
+            threadCounterCount = std::max(threadCounterCount.load(), id + 1);
+            slot.thread = std::thread(elasticWorker, id, std::ref(*pool));
+            running.push_back(id);
+        }
+        
+        // Shrink: newest threads retire after their current chunk
+        while (static_cast<int>(running.size()) > requested) {
+            pool->slots[running.back()].retire.store(true);
+            running.pop_back();
+        }
+        
+        if (controlFd < 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            continue;
+        }
+        
+        pollfd pfd{controlFd, POLLIN, 0};
+        if (poll(&pfd, 1, 100) <= 0) {
+            continue;
+        }
+        int client = accept(controlFd, nullptr, nullptr);
+        if (client < 0) {
+            continue;
+        }
+        LineChannel channel(client);
+        std::string line;
+        if (channel.readLine(line, 1000) != 1) {
+            continue;
+        }
+        std::istringstream command(line);
+        std::string verb, value;
+        command >> verb >> value;
+        char* end = nullptr;
+        long amount = verb == "THREADS" && !value.empty() ? std::strtol(value.c_str(), &end, 10) : 0;
+        if (verb == "THREADS" && (value.empty() || *end != '\0' || amount < -ELASTIC_MAX_THREADS ||
+                                  amount > ELASTIC_MAX_THREADS)) {
+            channel.sendLine("ERROR bad thread count");
+        } else if (verb == "THREADS") {
+            bool relative = value[0] == '+' || value[0] == '-';
+            int count = static_cast<int>(amount);
+            setRequested(relative ? requested + count : count, "control socket");
+            channel.sendLine("OK " + std::to_string(requested));
+        } else if (verb == "PAUSE" || verb == "RESUME") {
+            throttle.paused.store(verb == "PAUSE");
+            channel.sendLine("OK " + verb);
+        } else if (verb == "STATUS") {
+            channel.sendLine(std::string(throttle.paused.load() ? "PAUSED " : "") + "THREADS " + std::to_string(running.size()) + " REQUESTED " +
+                             std::to_string(requested) + " SEARCHED " +
+                             std::to_string(searchState.totalAttempts.load()) + " OF " +
+                             std::to_string(searchState.keySpaceSize));
+        } else {
+            channel.sendLine("ERROR expected THREADS <n|+n|-n>, PAUSE, RESUME or STATUS");
+        }
+    }
+    
+    if (searchState.interrupted.load()) {
+        recordUnfinished(std::min(pool->nextIndex.load(), pool->rangeEnd), pool->rangeEnd);
+    }
+    
+    signal(SIGTTIN, SIG_DFL);
+    signal(SIGTTOU, SIG_DFL);
+    if (controlFd >= 0) {
+        close(controlFd);
+        unlink(controlPath.c_str());
+    }
+}
+
+/**
+ * Probabilistic context-free grammar (PCFG) candidates
+ * 
+ * A password is parsed into runs of letters (L), digits (D) and other
+ * characters (S): "pass2024!" has the structure L4D4S1 with terminals
+ * "pass", "2024" and "!". Training counts structures and, per run kind
+ * and length, terminals; a guess's probability is its structure's times
+ * its terminals'. Terminals of equal probability are kept together in
+ * buckets, and a pre-terminal (structure plus one bucket per run) is
+ * expanded into all its guesses at once.
+ * 
+ * Pre-terminals come out of a max-heap in descending probability. Popping
+ * one pushes its children (one bucket index incremented at or after the
+ * parent's pivot), which visits every pre-terminal exactly once and never
+ * pushes one more likely than its parent.
+ */
+const uint32_t PCFG_MAGIC = 0x47464350;  // "PCFG"
+const uint32_t PCFG_VERSION = 1;
+const int PCFG_MAX_RUN = 32;             // longer runs are not trained
+const int PCFG_MAX_RUNS = 16;            // nor are structures with more runs
+
+struct PcfgBucket {
+    double probability = 0;   // of each terminal in the bucket
+    uint32_t terminals = 0;
+    uint64_t offset = 0;      // first byte in PcfgModel::arena
+};
+
+struct PcfgGroup {
+    char kind = 'L';
+    int length = 0;
+    std::vector<PcfgBucket> buckets;   // descending probability
+};
+
+struct PcfgStructure {
+    double probability = 0;
+    int length = 0;
+    std::vector<uint32_t> groups;      // one group per run
+};
+
+struct PcfgModel {
+    std::vector<PcfgGroup> groups;
+    std::vector<PcfgStructure> structures;
+    std::vector<char> arena;           // terminals, bucket by bucket
+    
+    bool save(const std::string& path) const;
+    bool load(const std::string& path);
+    
+    // Guesses in every structure, saturated at LLONG_MAX
+    long long guessCount() const {
+        const long long limit = std::numeric_limits<long long>::max();
+        long long total = 0;
+        for (const auto& structure : structures) {
+            long long product = 1;
+            for (uint32_t g : structure.groups) {
+                long long terminals = 0;
+                for (const auto& bucket : groups[g].buckets) {
+                    terminals += bucket.terminals;
+                }
+                if (__builtin_mul_overflow(product, terminals, &product)) {
+                    return limit;
+                }
+            }
+            if (__builtin_add_overflow(total, product, &total)) {
+                return limit;
+            }
+        }
+        return total;
+    }
+};
+
+char pcfgKind(unsigned char c) {
+    return std::isalpha(c) ? 'L' : std::isdigit(c) ? 'D' : 'S';
+}
+
+template <typename T>
+void writeBinary(std::ofstream& out, const T& value) {
+    out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <typename T>
+bool readBinary(std::ifstream& in, T& value) {
+    return static_cast<bool>(in.read(reinterpret_cast<char*>(&value), sizeof(value)));
+}
+
+/**
+ * Model file: magic, version, then the groups (kind, length, buckets of
+ * probability + terminal count), the structures (probability, run count,
+ * group indices) and finally the terminal arena; all little-endian. On
+ * disk a group takes at least 6 bytes, a bucket 12 and a structure 13.
+ */
+bool PcfgModel::save(const std::string& path) const {
+    std::ofstream out(path, std::ios::binary);
+    if (!out.is_open()) {
+        return false;
+    }
+    writeBinary(out, PCFG_MAGIC);
+    writeBinary(out, PCFG_VERSION);
+    writeBinary(out, static_cast<uint32_t>(groups.size()));
+    for (const auto& group : groups) {
+        writeBinary(out, static_cast<uint8_t>(group.kind));
+        writeBinary(out, static_cast<uint8_t>(group.length));
+        writeBinary(out, static_cast<uint32_t>(group.buckets.size()));
+        for (const auto& bucket : group.buckets) {
+            writeBinary(out, bucket.probability);
+            writeBinary(out, bucket.terminals);
+        }
+    }
+    writeBinary(out, static_cast<uint32_t>(structures.size()));
+    for (const auto& structure : structures) {
+        writeBinary(out, structure.probability);
+        writeBinary(out, static_cast<uint8_t>(structure.groups.size()));
+        for (uint32_t g : structure.groups) {
+            writeBinary(out, g);
+        }
+    }
+    writeBinary(out, static_cast<uint64_t>(arena.size()));
+    out.write(arena.data(), arena.size());
+    return out.good();
+}
+
+bool PcfgModel::load(const std::string& path) {
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in.is_open()) {
+        return false;
+    }
+    // Counts are checked against the bytes left before anything is
+    // allocated, so a truncated or forged file cannot ask for gigabytes
+    const uint64_t fileSize = static_cast<uint64_t>(in.tellg());
+    in.seekg(0);
+    auto fits = [&](uint64_t count, uint64_t recordBytes) {
+        std::streamoff position = in.tellg();
+        return position >= 0 && count <= (fileSize - static_cast<uint64_t>(position)) / recordBytes;
+    };
+    
+    uint32_t magic = 0, version = 0, groupCount = 0, structureCount = 0;
+    if (!readBinary(in, magic) || !readBinary(in, version) || magic != PCFG_MAGIC ||
+        version != PCFG_VERSION || !readBinary(in, groupCount) || !fits(groupCount, 6)) {
+        return false;
+    }
+    uint64_t offset = 0;
+    groups.assign(groupCount, PcfgGroup());
+    for (auto& group : groups) {
+        uint8_t kind = 0, length = 0;
+        uint32_t bucketCount = 0;
+        // Every group needs a terminal to offer, or guesses built on it
+        // would index an empty bucket list
+        if (!readBinary(in, kind) || !readBinary(in, length) || !readBinary(in, bucketCount) ||
+            length == 0 || length > PCFG_MAX_RUN || bucketCount == 0 || !fits(bucketCount, 12)) {
+            return false;
+        }
+        group.kind = static_cast<char>(kind);
+        group.length = length;
+        group.buckets.assign(bucketCount, PcfgBucket());
+        for (auto& bucket : group.buckets) {
+            if (!readBinary(in, bucket.probability) || !readBinary(in, bucket.terminals) ||
+                bucket.terminals == 0) {
+                return false;
+            }
+            bucket.offset = offset;
+            offset += static_cast<uint64_t>(bucket.terminals) * group.length;
+        }
+    }
+    if (!readBinary(in, structureCount) || !fits(structureCount, 13)) {
+        return false;
+    }
+    structures.assign(structureCount, PcfgStructure());
+    for (auto& structure : structures) {
+        uint8_t runs = 0;
+        // The generator keeps per-run state in PCFG_MAX_RUNS-sized arrays
+        if (!readBinary(in, structure.probability) || !readBinary(in, runs) ||
+            runs == 0 || runs > PCFG_MAX_RUNS) {
+            return false;
+        }
+        structure.groups.assign(runs, 0);
+        for (auto& g : structure.groups) {
+            if (!readBinary(in, g) || g >= groupCount) {
+                return false;
+            }
+            structure.length += groups[g].length;
+        }
+    }
+    uint64_t arenaSize = 0;
+    if (!readBinary(in, arenaSize) || arenaSize != offset || !fits(arenaSize, 1)) {
+        return false;
+    }
+    arena.resize(arenaSize);
+    return static_cast<bool>(in.read(arena.data(), arenaSize));
+}
+
+/**
+ * Train a model from a corpus with one password per line
+ * 
+ * Usage: train-pcfg <corpus> <model>
+ */
+int runPcfgTrainer(int argc, char* argv[]) {
+    if (argc < 4) {
+        std::cerr << "Usage: " << argv[0] << " train-pcfg <corpus> <model>\n";
+        return 1;
+    }
+    std::ifstream corpus(argv[2]);
+    if (!corpus.is_open()) {
+        std::cerr << "Error: could not open " << argv[2] << "\n";
+        return 1;
+    }
+    
+    // Group key "L6" etc. -> terminal counts; structure key "L6D2" -> runs
+    std::map<std::string, std::map<std::string, long long>> terminalCounts;
+    std::map<std::string, std::pair<long long, std::vector<std::string>>> structureCounts;
+    long long trained = 0, skipped = 0;
+    std::string line;
+    while (std::getline(corpus, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (line.empty()) {
+            continue;
+        }
+        std::vector<std::string> runs, keys;
+        bool usable = true;
+        for (size_t i = 0; i < line.size() && usable;) {
+            size_t j = i;
+            char kind = pcfgKind(line[i]);
+            while (j < line.size() && pcfgKind(line[j]) == kind) {
+                j++;
+            }
+            usable = j - i <= static_cast<size_t>(PCFG_MAX_RUN) && runs.size() < PCFG_MAX_RUNS;
+            runs.push_back(line.substr(i, j - i));
+            keys.push_back(kind + std::to_string(j - i));
+            i = j;
+        }
+        if (!usable) {
+            skipped++;
+            continue;
+        }
+        std::string structureKey;
+        for (size_t r = 0; r < runs.size(); ++r) {
+            terminalCounts[keys[r]][runs[r]]++;
+            structureKey += keys[r];
+        }
+        auto& entry = structureCounts[structureKey];
+        entry.first++;
+        entry.second = keys;
+        trained++;
+    }
+    if (trained == 0) {
+        std::cerr << "Error: no usable passwords in " << argv[2] << "\n";
+        return 1;
+    }
+    
+    // Buckets of equal count, most frequent first
+    PcfgModel model;
+    std::map<std::string, uint32_t> groupIndex;
+    for (const auto& entry : terminalCounts) {
+        PcfgGroup group;
+        group.kind = entry.first[0];
+        group.length = std::stoi(entry.first.substr(1));
+        long long groupTotal = 0;
+        std::map<long long, std::vector<std::string>, std::greater<long long>> byCount;
+        for (const auto& terminal : entry.second) {
+            groupTotal += terminal.second;
+            byCount[terminal.second].push_back(terminal.first);
+        }
+        for (const auto& bucketEntry : byCount) {
+            PcfgBucket bucket;
+            bucket.probability = static_cast<double>(bucketEntry.first) / groupTotal;
+            bucket.terminals = static_cast<uint32_t>(bucketEntry.second.size());
+            bucket.offset = model.arena.size();
+            for (const auto& terminal : bucketEntry.second) {
+                model.arena.insert(model.arena.end(), terminal.begin(), terminal.end());
+            }
+            group.buckets.push_back(bucket);
+        }
+        groupIndex[entry.first] = static_cast<uint32_t>(model.groups.size());
+        model.groups.push_back(group);
+    }
+    for (const auto& entry : structureCounts) {
+        PcfgStructure structure;
+        structure.probability = static_cast<double>(entry.second.first) / trained;
+        for (const auto& key : entry.second.second) {
+            structure.groups.push_back(groupIndex[key]);
+            structure.length += model.groups[groupIndex[key]].length;
+        }
+        model.structures.push_back(structure);
+    }
+    std::sort(model.structures.begin(), model.structures.end(),
+              [](const PcfgStructure& a, const PcfgStructure& b) { return a.probability > b.probability; });
+    
+    if (!model.save(argv[3])) {
+        std::cerr << "Error: could not write " << argv[3] << "\n";
+        return 1;
+    }
+    std::cout << "Trained on " << trained << " passwords (" << skipped << " skipped): "
+              << model.structures.size() << " structures, " << model.groups.size()
+              << " terminal groups, " << model.arena.size() << " terminal bytes\n";
+    std::cout << "Model written to " << argv[3] << " (" << model.guessCount() << " guesses)\n";
+    return 0;
+}
+
+// A structure with one bucket chosen per run
+struct PcfgPreterminal {
+    double probability;
+    uint32_t structure;
+    uint8_t pivot;
+    uint32_t bucket[PCFG_MAX_RUNS];
+    
+    bool operator<(const PcfgPreterminal& other) const {
+        return probability < other.probability;
+    }
+};
+
+/**
+ * Shared dispenser: the heap of pre-terminals plus the one currently being
+ * handed out in batches
+ * 
+ * The lock is held for one batch (or one heap pop and its pushes), while
+ * the candidates of a batch are generated and hashed without it.
+ */
+class PcfgDispenser {
+public:
+    static const long long BATCH = 4096;
+    
+    PcfgDispenser(const PcfgModel& model, long long budget) : model(model), budget(budget) {
+        for (uint32_t s = 0; s < model.structures.size(); ++s) {
+            PcfgPreterminal root{};
+            root.structure = s;
+            root.probability = probabilityOf(root);
+            heap.push_back(root);
+        }
+        std::make_heap(heap.begin(), heap.end());
+    }
+    
+    /**
+     * Next batch: guesses [first, last) of pre-terminal `out`
+     * 
+     * @return false once the grammar or the budget is exhausted
+     */
+    bool next(PcfgPreterminal& out, long long& first, long long& last) {
+        std::lock_guard<std::mutex> lock(mutex);
+        while (cursor >= currentSize) {
+            if (heap.empty() || handedOut >= budget) {
+                return false;
+            }
+            std::pop_heap(heap.begin(), heap.end());
+            current = heap.back();
+            heap.pop_back();
+            pushChildren(current);
+            currentSize = guessesIn(current);
+            cursor = 0;
+            preterminals++;
+        }
+        out = current;
+        first = cursor;
+        last = cursor + std::min({currentSize - cursor, BATCH, budget - handedOut});
+        handedOut += last - first;
+        cursor = last;
+        return first < last;
+    }
+    
+    long long guessesIn(const PcfgPreterminal& node) const {
+        long long product = 1;
+        const auto& structure = model.structures[node.structure];
+        for (size_t r = 0; r < structure.groups.size(); ++r) {
+            long long terminals = model.groups[structure.groups[r]].buckets[node.bucket[r]].terminals;
+            if (__builtin_mul_overflow(product, terminals, &product)) {
+                return std::numeric_limits<long long>::max();
+            }
+        }
+        return product;
+    }
+    
+    long long preterminalCount() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return preterminals;
+    }
+    
+private:
+    double probabilityOf(const PcfgPreterminal& node) const {
+        const auto& structure = model.structures[node.structure];
+        double probability = structure.probability;
+        for (size_t r = 0; r < structure.groups.size(); ++r) {
+            probability *= model.groups[structure.groups[r]].buckets[node.bucket[r]].probability;
+        }
+        return probability;
+    }
+    
+    void pushChildren(const PcfgPreterminal& parent) {
+        const auto& structure = model.structures[parent.structure];
+        for (size_t r = parent.pivot; r < structure.groups.size(); ++r) {
+            if (parent.bucket[r] + 1u < model.groups[structure.groups[r]].buckets.size()) {
+                PcfgPreterminal child = parent;
+                child.bucket[r]++;
+                child.pivot = static_cast<uint8_t>(r);
+                child.probability = probabilityOf(child);
+                heap.push_back(child);
+                std::push_heap(heap.begin(), heap.end());
+            }
+        }
+    }
+    
+    const PcfgModel& model;
+    std::mutex mutex;
+    std::vector<PcfgPreterminal> heap;
+    PcfgPreterminal current{};
+    long long currentSize = 0;
+    long long cursor = 0;
+    long long budget;
+    long long handedOut = 0;
+    long long preterminals = 0;
+};
+
+/**
+ * PCFG worker: generates and hashes batches until the dispenser runs dry
+ */
+void pcfgWorker(int threadId, const PcfgModel& model, PcfgDispenser& dispenser) {
+    auto threadStartTime = std::chrono::steady_clock::now();
+    applyWorkerPriority();
+    long long attempts = 0;
+    long long unflushed = 0;
+    long long filtered = 0;
+    std::string candidate;
+    PcfgPreterminal node;
+    long long first = 0, last = 0;
+    
+    while (!searchState.stopRequested.load() && dispenser.next(node, first, last)) {
+        const auto& structure = model.structures[node.structure];
+        const PcfgBucket* buckets[PCFG_MAX_RUNS];
+        for (size_t r = 0; r < structure.groups.size(); ++r) {
+            buckets[r] = &model.groups[structure.groups[r]].buckets[node.bucket[r]];
+        }
+        candidate.resize(structure.length);
+        
+        for (long long guess = first; guess < last; ++guess) {
+            // Mixed-radix decode, last run varying fastest
+            long long rest = guess;
+            int position = structure.length;
+            for (int r = static_cast<int>(structure.groups.size()) - 1; r >= 0; --r) {
+                int length = model.groups[structure.groups[r]].length;
+                long long terminal = rest % buckets[r]->terminals;
+                rest /= buckets[r]->terminals;
+                position -= length;
+                std::memcpy(&candidate[position], &model.arena[buckets[r]->offset + terminal * length],
+                            length);
+            }
+            attempts++;
+            unflushed++;
+            if (passwordPolicy.enabled && !policyAllows(candidate)) {
+                filtered++;
+                continue;
+            }
+            if (simpleHash(candidate) == searchState.targetHash) {
+                claimFound(threadId, candidate, attempts, unflushed);
+                break;
+            }
+        }
+        
+        // One batch is a few thousand guesses, so flush once per batch
+        searchState.totalAttempts.fetch_add(unflushed);
+        searchState.skippedCandidates.fetch_add(filtered, std::memory_order_relaxed);
+        searchState.filteredCandidates.fetch_add(filtered, std::memory_order_relaxed);
+        unflushed = 0;
+        filtered = 0;
+        threadCounters[threadId].attempts.store(attempts, std::memory_order_relaxed);
+    }
+    
+    recordThreadCompletion(threadId, attempts, threadStartTime);
+}
+
+/**
+ * Run a PCFG search with `numThreads` workers, stopping after `budget`
+ * guesses; returns the number of pre-terminals expanded
+ */
+long long runPcfgSearch(const PcfgModel& model, int numThreads, long long budget) {
+    PcfgDispenser dispenser(model, budget);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < numThreads; ++i) {
+        threads.emplace_back(pcfgWorker, i, std::cref(model), std::ref(dispenser));
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    return dispenser.preterminalCount();
+}
+
+/**
+ * Compressed wordlist streaming
+ * 
+ * A gzip list cannot be index-addressed, so it is streamed instead of
+ * mmapped. One decompression thread per file fills large buffers from a
+ * bounded ring and publishes them; hashing workers take a full buffer, hash
+ * its lines in place and hand it back. A buffer always holds whole lines:
+ * the partial line at the end of a fill is carried to the start of that
+ * producer's next buffer. When every buffer is full the producers block
+ * (backpressure), and when none is the workers block; the time each side
+ * spends blocked shows which stage limits the run.
+ */
+class BufferRing {
+public:
+    struct Buffer {
+        std::unique_ptr<char[]> data;
+        size_t used = 0;
+    };
+    
+    BufferRing(int count, int producers) : buffers(count), activeProducers(producers) {
+        for (int slot = 0; slot < count; ++slot) {
+            buffers[slot].data.reset(new char[STREAM_BUFFER_SIZE]);
+            freeSlots.push_back(slot);
+        }
+    }
+    
+    // Empty buffer for a producer; -1 once the search stops
+    int acquireFree() { return take(freeSlots, freeReady, producerBlockedNanos, false); }
+    
+    // Full buffer for a worker; -1 once the producers are done and the ring
+    // has drained, or the search stops
+    int acquireFull() { return take(fullSlots, fullReady, workerStarvedNanos, true); }
+    
+    void publish(int slot) { give(fullSlots, fullReady, slot); }
+    void release(int slot) { give(freeSlots, freeReady, slot); }
+    
+    void producerDone() {
+        std::lock_guard<std::mutex> lock(mutex);
+        activeProducers--;
+        fullReady.notify_all();
+    }
+    
+    std::vector<Buffer> buffers;
+    std::atomic<long long> producerBlockedNanos{0};
+    std::atomic<long long> workerStarvedNanos{0};
+    
+private:
+    int take(std::deque<int>& slots, std::condition_variable& ready, std::atomic<long long>& blocked,
+             bool consumer) {
+        std::unique_lock<std::mutex> lock(mutex);
+        auto start = std::chrono::steady_clock::now();
+        // Timed waits so a found password or a signal ends blocked threads
+        while (slots.empty() && !searchState.stopRequested.load() && !(consumer && activeProducers == 0)) {
+            ready.wait_for(lock, std::chrono::milliseconds(100));
+        }
+        blocked.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count(), std::memory_order_relaxed);
+        if (slots.empty() || searchState.stopRequested.load()) {
+            return -1;
+        }
+        int slot = slots.front();
+        slots.pop_front();
+        return slot;
+    }
+    
+    void give(std::deque<int>& slots, std::condition_variable& ready, int slot) {
+        std::lock_guard<std::mutex> lock(mutex);
+        slots.push_back(slot);
+        ready.notify_one();
+    }
+    
+    std::mutex mutex;
+    std::condition_variable freeReady;
+    std::condition_variable fullReady;
+    std::deque<int> freeSlots;
+    std::deque<int> fullSlots;
+    int activeProducers;
+};
+
+// gzip member magic
+bool isGzipFile(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    unsigned char magic[2] = {0, 0};
+    file.read(reinterpret_cast<char*>(magic), 2);
+    return file.gcount() == 2 && magic[0] == 0x1f && magic[1] == 0x8b;
+}
+
+void decompressWorker(const std::string& path, BufferRing& ring) {
+    gzFile file = gzopen(path.c_str(), "rb");
+    if (file == nullptr) {
+        std::lock_guard<std::mutex> lock(perfMetrics.outputMutex);
+        streamStats.error = "cannot open " + path;
+        ring.producerDone();
+        return;
+    }
+    gzbuffer(file, 1 << 20);
+    std::string carry;   // partial last line of the previous buffer
+    
+    for (bool done = false; !done;) {
+        int slot = ring.acquireFree();
+        if (slot < 0) {
+            break;
+        }
+        BufferRing::Buffer& buffer = ring.buffers[slot];
+        std::memcpy(buffer.data.get(), carry.data(), carry.size());
+        buffer.used = carry.size();
+        carry.clear();
+        
+        auto start = std::chrono::steady_clock::now();
+        int read = gzread(file, buffer.data.get() + buffer.used,
+                          static_cast<unsigned>(STREAM_BUFFER_SIZE - buffer.used));
+        streamStats.producerBusyNanos.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count(), std::memory_order_relaxed);
+        if (read < 0) {
+            int code = 0;
+            std::lock_guard<std::mutex> lock(perfMetrics.outputMutex);
+            streamStats.error = path + ": " + gzerror(file, &code);
+            read = 0;
+        }
+        buffer.used += read;
+        done = buffer.used < STREAM_BUFFER_SIZE;
+        
+        // Keep whole lines; a line longer than a buffer is cut
+        if (!done) {
+            const void* newline = memrchr(buffer.data.get(), '\n', buffer.used);
+            if (newline != nullptr) {
+                size_t keep = static_cast<const char*>(newline) - buffer.data.get() + 1;
+                carry.assign(buffer.data.get() + keep, buffer.used - keep);
+                buffer.used = keep;
+            }
+        }
+        streamStats.bytes.fetch_add(buffer.used, std::memory_order_relaxed);
+        if (buffer.used > 0) {
+            ring.publish(slot);
+        } else {
+            ring.release(slot);
+        }
+    }
+    gzclose(file);
+    ring.producerDone();
+}
+
+/**
+ * Hash the lines of [line, end) in place, then flush the counters once;
+ * shared by the streamed sources, whose buffers and batches hold whole lines
+ * 
+ * @return true if this thread found the password
+ */
+bool hashLines(int threadId, const char* line, const char* end, long long& attempts) {
+    long long unflushed = 0;
+    long long filtered = 0;
+    bool found = false;
+    while (line < end) {
+        const char* newline = static_cast<const char*>(std::memchr(line, '\n', end - line));
+        const char* next = newline ? newline + 1 : end;
+        size_t length = (newline ? newline : end) - line;
+        if (length > 0 && line[length - 1] == '\r') {
+            length--;
+        }
+        if (length > 0) {
+            attempts++;
+            unflushed++;
+            std::string_view word(line, length);
+            if (passwordPolicy.enabled && !policyAllows(word)) {
+                filtered++;
+            } else if (simpleHash(word) == searchState.targetHash) {
+                found = claimFound(threadId, std::string(word), attempts, unflushed);
+                break;
+            }
+        }
+        line = next;
+    }
+    
+    searchState.totalAttempts.fetch_add(unflushed);
+    searchState.skippedCandidates.fetch_add(filtered, std::memory_order_relaxed);
+    searchState.filteredCandidates.fetch_add(filtered, std::memory_order_relaxed);
+    threadCounters[threadId].attempts.store(attempts, std::memory_order_relaxed);
+    return found;
+}
+
+void streamWorker(int threadId, BufferRing& ring) {
+    auto threadStartTime = std::chrono::steady_clock::now();
+    applyWorkerPriority();
+    long long attempts = 0;
+    
+    for (int slot; (slot = ring.acquireFull()) >= 0;) {
+        auto start = std::chrono::steady_clock::now();
+        const char* data = ring.buffers[slot].data.get();
+        hashLines(threadId, data, data + ring.buffers[slot].used, attempts);
+        ring.release(slot);
+        streamStats.workerBusyNanos.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count(), std::memory_order_relaxed);
+    }
+    
+    recordThreadCompletion(threadId, attempts, threadStartTime);
+}
+
+/**
+ * Stream `files` through a ring of 2 buffers per thread: one decompression
+ * thread per file, `numThreads` hashing workers
+ */
+void runStreamSearch(const std::vector<std::string>& files, int numThreads) {
+    int producers = static_cast<int>(files.size());
+    streamStats.files = files;
+    streamStats.producers = producers;
+    streamStats.workers = numThreads;
+    streamStats.buffers = 2 * (producers + numThreads);
+    for (const auto& path : files) {
+        struct stat info;
+        if (stat(path.c_str(), &info) == 0) {
+            streamStats.compressedBytes += info.st_size;
+        }
+    }
+    
+    auto start = std::chrono::steady_clock::now();
+    BufferRing ring(streamStats.buffers, producers);
+    std::vector<std::thread> threads;
+    for (const auto& path : files) {
+        threads.emplace_back(decompressWorker, std::cref(path), std::ref(ring));
+    }
+    for (int i = 0; i < numThreads; ++i) {
+        threads.emplace_back(streamWorker, i, std::ref(ring));
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    streamStats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    streamStats.producerBlockedNanos = ring.producerBlockedNanos.load();
+    streamStats.workerStarvedNanos = ring.workerStarvedNanos.load();
+}
+
+/**
+ * Bounded lock-free MPMC queue (Vyukov)
+ * 
+ * Every cell carries a sequence number that tells whether it is ready for
+ * the next push (sequence == position) or the next pop (sequence ==
+ * position + 1). Producers and consumers each claim positions with a CAS on
+ * their own counter, so neither side ever waits on a lock held by the other.
+ * push() and pop() return false when the queue is full or empty.
+ */
+template <typename T>
+class LockFreeQueue {
+public:
+    explicit LockFreeQueue(size_t capacity) {
+        size_t size = 2;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        cells.reset(new Cell[size]);
+        mask = size - 1;
+        for (size_t i = 0; i < size; ++i) {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+    
+    bool push(const T& value) {
+        size_t position = tail.load(std::memory_order_relaxed);
+        Cell* cell;
+        for (;;) {
+            cell = &cells[position & mask];
+            size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+            if (difference == 0) {
+                if (tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (difference < 0) {
+                return false;
+            } else {
+                position = tail.load(std::memory_order_relaxed);
+            }
+        }
+        cell->value = value;
+        cell->sequence.store(position + 1, std::memory_order_release);
+        return true;
+    }
+    
+    bool pop(T& value) {
+        size_t position = head.load(std::memory_order_relaxed);
+        Cell* cell;
+        for (;;) {
+            cell = &cells[position & mask];
+            size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position + 1);
+            if (difference == 0) {
+                if (head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (difference < 0) {
+                return false;
+            } else {
+                position = head.load(std::memory_order_relaxed);
+            }
+        }
+        value = cell->value;
+        cell->sequence.store(position + mask + 1, std::memory_order_release);
+        return true;
+    }
+    
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+    std::unique_ptr<Cell[]> cells;
+    size_t mask;
+    alignas(64) std::atomic<size_t> tail{0};
+    alignas(64) std::atomic<size_t> head{0};
+};
+
+/**
+ * Candidates from standard input (--stdin)
+ * 
+ * One reader thread read(2)s into 4 MB blocks and cuts each block at line
+ * ends into batches of about 64 KB. A batch is just a pointer range into
+ * its block, so lines are never copied; only a line split across two blocks
+ * is moved to the start of the next one. Batches go to the hashing workers
+ * through a lock-free queue. Each block counts the batches still using it,
+ * and the worker that finishes the last one returns the block to the free
+ * queue. The reader polls stdin with a timeout, so a slow generator still
+ * gets its complete lines hashed promptly and a found password ends the run
+ * without waiting for more input.
+ */
+struct LineBatch {
+    int block;
+    const char* begin;
+    const char* end;
+};
+
+class StdinPipeline {
+public:
+    explicit StdinPipeline(int blockCount)
+        : blocks(blockCount), references(new std::atomic<int>[blockCount]), freeBlocks(blockCount),
+          batches(static_cast<size_t>(blockCount) * (STDIN_BLOCK_SIZE / STDIN_BATCH_SIZE) * 2) {
+        for (int b = 0; b < blockCount; ++b) {
+            blocks[b].reset(new char[STDIN_BLOCK_SIZE]);
+            references[b].store(0);
+            freeBlocks.push(b);
+        }
+    }
+    
+    void read() {
+        std::string carry;   // partial last line of the previous block
+        bool done = false;
+        while (!done) {
+            int block = takeFreeBlock();
+            if (block < 0) {
+                break;
+            }
+            char* data = blocks[block].get();
+            references[block].store(1);   // the reader's own reference
+            std::memcpy(data, carry.data(), carry.size());
+            size_t used = carry.size();
+            size_t dispatched = 0;
+            carry.clear();
+            
+            while (used < STDIN_BLOCK_SIZE && !done) {
+                bool idle = false;
+                done = !fill(data, used, idle);
+                const void* newline = memrchr(data + dispatched, '\n', used - dispatched);
+                size_t complete = newline ? static_cast<const char*>(newline) - data + 1 : dispatched;
+                // Whole batches as they fill; everything complete when input stalls
+                if (complete - dispatched >= STDIN_BATCH_SIZE || (idle && complete > dispatched)) {
+                    if (!dispatch(block, data, dispatched, complete)) {
+                        done = true;
+                    }
+                }
+            }
+            if (!done) {
+                // Block full: the tail after its last newline continues in the
+                // next block, unless the whole block is one line
+                const void* newline = memrchr(data + dispatched, '\n', used - dispatched);
+                size_t complete = newline ? static_cast<const char*>(newline) - data + 1
+                                          : (dispatched > 0 ? dispatched : used);
+                carry.assign(data + complete, used - complete);
+                used = complete;
+            }
+            if (!searchState.stopRequested.load()) {
+                dispatch(block, data, dispatched, used);
+            }
+            releaseBlock(block);
+        }
+        finished.store(true, std::memory_order_release);
+    }
+    
+    void work(int threadId) {
+        auto threadStartTime = std::chrono::steady_clock::now();
+        applyWorkerPriority();
+        long long attempts = 0;
+        LineBatch batch;
+        
+        while (!searchState.stopRequested.load(std::memory_order_relaxed)) {
+            if (!batches.pop(batch)) {
+                // finished is set after the last push, so re-check the queue once
+                if (finished.load(std::memory_order_acquire) && !batches.pop(batch)) {
+                    break;
+                }
+                if (!waitForBatch(batch)) {
+                    continue;
+                }
+            }
+            hashLines(threadId, batch.begin, batch.end, attempts);
+            releaseBlock(batch.block);
+        }
+        
+        recordThreadCompletion(threadId, attempts, threadStartTime);
+    }
+    
+private:
+    /**
+     * Append input to the block with one read(2)
+     * 
+     * @param idle set when no input arrived within the poll timeout
+     * @return false at end of input, on a read error or when the search stops
+     */
+    bool fill(char* data, size_t& used, bool& idle) {
+        auto start = std::chrono::steady_clock::now();
+        pollfd input{STDIN_FILENO, POLLIN, 0};
+        int ready = poll(&input, 1, 50);
+        ssize_t count = 0;
+        if (ready > 0) {
+            count = ::read(STDIN_FILENO, data + used, STDIN_BLOCK_SIZE - used);
+        }
+        stdinStats.readNanos.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count(), std::memory_order_relaxed);
+        if (searchState.stopRequested.load()) {
+            return false;
+        }
+        if (ready == 0 || (ready < 0 && errno == EINTR) || (count < 0 && errno == EINTR)) {
+            idle = true;
+            return true;
+        }
+        if (ready < 0 || count < 0) {
+            stdinStats.error = std::string("read: ") + std::strerror(errno);
+            return false;
+        }
+        used += count;
+        stdinStats.bytes.fetch_add(count, std::memory_order_relaxed);
+        return count > 0;
+    }
+    
+    // Queue [dispatched, end) as batches of about STDIN_BATCH_SIZE bytes
+    bool dispatch(int block, char* data, size_t& dispatched, size_t end) {
+        while (dispatched < end) {
+            size_t cut = end;
+            if (end - dispatched > STDIN_BATCH_SIZE) {
+                const void* newline = memrchr(data + dispatched, '\n', STDIN_BATCH_SIZE);
+                if (newline == nullptr) {   // one line longer than a batch
+                    newline = std::memchr(data + dispatched + STDIN_BATCH_SIZE, '\n',
+                                          end - dispatched - STDIN_BATCH_SIZE);
+                }
+                cut = newline ? static_cast<const char*>(newline) - data + 1 : end;
+            }
+            references[block].fetch_add(1, std::memory_order_relaxed);
+            LineBatch batch{block, data + dispatched, data + cut};
+            if (!pushBatch(batch)) {
+                references[block].fetch_sub(1, std::memory_order_relaxed);
+                return false;
+            }
+            dispatched = cut;
+            stdinStats.batches.fetch_add(1, std::memory_order_relaxed);
+        }
+        return true;
+    }
+    
+    bool pushBatch(const LineBatch& batch) {
+        if (batches.push(batch)) {
+            return true;
+        }
+        auto start = std::chrono::steady_clock::now();
+        bool pushed = false;
+        while (!(pushed = batches.push(batch)) && !searchState.stopRequested.load()) {
+            std::this_thread::yield();
+        }
+        stdinStats.readerBlockedNanos.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count(), std::memory_order_relaxed);
+        return pushed;
+    }
+    
+    int takeFreeBlock() {
+        int block;
+        if (freeBlocks.pop(block)) {
+            return block;
+        }
+        // Every block still has batches in flight: hashing is behind
+        auto start = std::chrono::steady_clock::now();
+        bool taken = false;
+        while (!(taken = freeBlocks.pop(block)) && !searchState.stopRequested.load()) {
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+        stdinStats.readerBlockedNanos.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count(), std::memory_order_relaxed);
+        return taken ? block : -1;
+    }
+    
+    void releaseBlock(int block) {
+        if (references[block].fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            freeBlocks.push(block);
+        }
+    }
+    
+    // Spin briefly, then sleep in short steps until a batch, the end of
+    // input or a stop; the time counts as starvation
+    bool waitForBatch(LineBatch& batch) {
+        stdinStats.emptyPolls.fetch_add(1, std::memory_order_relaxed);
+        auto start = std::chrono::steady_clock::now();
+        bool popped = false;
+        for (int spin = 0; !searchState.stopRequested.load(std::memory_order_relaxed); ++spin) {
+            if ((popped = batches.pop(batch)) || finished.load(std::memory_order_acquire)) {
+                break;
+            }
+            if (spin < 64) {
+                std::this_thread::yield();
+            } else {
+                std::this_thread::sleep_for(std::chrono::microseconds(50));
+            }
+        }
+        stdinStats.starvedNanos.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count(), std::memory_order_relaxed);
+        return popped;
+    }
+    
+    std::vector<std::unique_ptr<char[]>> blocks;
+    std::unique_ptr<std::atomic<int>[]> references;
+    LockFreeQueue<int> freeBlocks;
+    LockFreeQueue<LineBatch> batches;
+    std::atomic<bool> finished{false};
+};
+
+/**
+ * Hash every line of standard input with `numThreads` workers and one reader
+ */
+void runStdinSearch(int numThreads) {
+    stdinStats.workers = numThreads;
+    stdinStats.blocks = 2 * numThreads + 2;
+    auto start = std::chrono::steady_clock::now();
+    StdinPipeline pipeline(stdinStats.blocks);
+    std::vector<std::thread> threads;
+    threads.emplace_back(&StdinPipeline::read, &pipeline);
+    for (int i = 0; i < numThreads; ++i) {
+        threads.emplace_back(&StdinPipeline::work, &pipeline, i);
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    stdinStats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * Keep a benchmark's result alive so the loop computing it is not
+ * optimised away; the empty asm claims to read the value
+ */
+template <typename T>
+inline void doNotOptimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+/**
+ * `bench-order` subcommand: per-candidate cost of the permuted order
+ * 
+ * Generates and hashes the same number of length-maxLength candidates in
+ * sequential and in permuted order on one thread (so both hash strings of
+ * the same length), after checking on a small space that the permutation
+ * really is a bijection.
+ * 
+ * Usage: bench-order [maxLength] [candidates]
+ */
+int runOrderBenchmark(int argc, char* argv[]) {
+    int maxLength = argc >= 3 ? std::stoi(argv[2]) : 6;
+    long long count = argc >= 4 ? std::stoll(argv[3]) : 20000000;
+    long long tierStart = calculateKeySpace(maxLength - 1);
+    long long tierSize = calculateKeySpace(maxLength) - tierStart;
+    count = std::min(count, tierSize);
+    
+    // Bijection check over lengths 1-3
+    EnumerationOrder check;
+    long long small = calculateKeySpace(3);
+    check.setup(0, small, 12345);
+    std::vector<char> seen(small, 0);
+    bool bijective = true;
+    for (long long p = 0; p < small; ++p) {
+        long long index = check.map(p);
+        if (index < 0 || index >= small || seen[index]) {
+            bijective = false;
+            break;
+        }
+        seen[index] = 1;
+    }
+    
+    auto run = [&](bool permuted) {
+        EnumerationOrder order;
+        order.setup(tierStart, tierSize, 1);
+        uint32_t sink = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (long long p = tierStart; p < tierStart + count; ++p) {
+            sink ^= simpleHash(indexToPassword(permuted ? order.map(p) : p, maxLength));
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        doNotOptimize(sink);
+        return seconds * 1e9 / count;
+    };
+    
+    double sequential = run(false);
+    double permuted = run(true);
+    
+    std::cout << "Enumeration order benchmark (" << count << " candidates, max length "
+              << maxLength << ", 1 thread)\n";
+    std::cout << "  Bijection check (lengths 1-3): " << (bijective ? "OK" : "FAILED") << "\n";
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "  Sequential: " << sequential << " ns/candidate\n";
+    std::cout << "  Permuted:   " << permuted << " ns/candidate\n";
+    std::cout << "  Overhead:   " << (permuted - sequential) << " ns/candidate ("
+              << std::setprecision(1) << (100.0 * (permuted - sequential) / sequential) << "%)\n";
+    return bijective ? 0 : 1;
+}
+
+/**
+ * Compare the fused brute-force pipeline with the hand-written loop it
+ * replaced
+ * 
+ * Both hash the same length-maxLength candidates on one thread; each is
+ * run three times, interleaved, and the best time is reported. The
+ * target hash is one no candidate of up to six characters can produce,
+ * so both run to the end.
+ * 
+ * Usage: bench-pipeline [maxLength] [candidates]
+ */
+int runPipelineBenchmark(int argc, char* argv[]) {
+    int maxLength = std::min(6, argc >= 3 ? std::stoi(argv[2]) : 6);
+    long long count = argc >= 4 ? std::stoll(argv[3]) : 30000000;
+    long long tierStart = calculateKeySpace(maxLength - 1);
+    count = std::min(count, calculateKeySpace(maxLength) - tierStart);
+    long long end = tierStart + count;
+    searchState.targetHash = 0xffffffffu;
+    threadCounters.reset(new ThreadCounter[1]);
+    
+    // The loop every mode used before the pipeline existed
+    auto handWritten = [&] {
+        long long attempts = 0;
+        for (long long i = tierStart; i < end; ++i) {
+            std::string candidate = indexToPassword(i, maxLength);
+            if (simpleHash(candidate) == searchState.targetHash) {
+                break;
+            }
+            attempts++;
+        }
+        return attempts;
+    };
+    
+    auto fused = [&] {
+        long long attempts = 0;
+        CandidatePipeline<BruteForceSource> pipeline{BruteForceSource{maxLength}, {}, {}, {}};
+        pipeline.search<false>(0, tierStart, end, attempts);
+        return attempts;
+    };
+    
+    double best[2] = {1e300, 1e300};
+    bool complete = true;
+    for (int round = 0; round < 3; ++round) {
+        for (int variant = 0; variant < 2; ++variant) {
+            auto start = std::chrono::steady_clock::now();
+            long long hashed = variant == 0 ? handWritten() : fused();
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            best[variant] = std::min(best[variant], seconds * 1e9 / count);
+            complete = complete && hashed == count;
+        }
+    }
+    
+    std::cout << "Pipeline benchmark (" << count << " candidates of length " << maxLength
+              << ", 1 thread, best of 3)\n";
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "  Hand-written loop: " << best[0] << " ns/candidate\n";
+    std::cout << "  Fused pipeline:    " << best[1] << " ns/candidate ("
+              << std::setprecision(1) << (100.0 * best[1] / best[0]) << "% of hand-written)\n";
+    if (!complete) {
+        std::cout << "  Warning: a run stopped early on a hash match\n";
+    }
+    return complete ? 0 : 1;
+}
+
+/**
+ * External sort/dedup for wordlists larger than RAM
+ * 
+ * Phase 1 cuts the input into chunks that fit the memory budget; sorter
+ * threads sort and deduplicate chunks in parallel (counting repeats) and
+ * spill each as a sorted run. A k-way merge of the runs then streams out
+ * every distinct word once. With --by-frequency the merged (word, count)
+ * stream goes through the same machinery a second time, ordered by count,
+ * so the most common words come first.
+ * 
+ * Runs are binary records: uint32 length, uint64 count, then the bytes.
+ */
+struct SpillChunk {
+    struct Entry {
+        uint32_t offset;
+        uint32_t length;
+        uint64_t count;
+    };
+    std::vector<char> bytes;
+    std::vector<Entry> entries;
+    
+    std::string_view word(const Entry& entry) const {
+        return std::string_view(bytes.data() + entry.offset, entry.length);
+    }
+};
+
+class SpillRuns {
+public:
+    /**
+     * @param chunkBytes  memory for one chunk (word bytes plus entries)
+     * @param byFrequency order runs by descending count instead of by word
+     */
+    SpillRuns(const std::string& prefix, int threads, size_t chunkBytes, bool byFrequency)
+        : prefix(prefix), chunkBytes(chunkBytes), byFrequency(byFrequency) {
+        for (int i = 0; i < threads; ++i) {
+            sorters.emplace_back(&SpillRuns::sorterLoop, this);
+        }
+        filling = newChunk();
+    }
+    
+    void add(const char* word, size_t length, uint64_t count) {
+        if (filling->bytes.size() + length > filling->bytes.capacity() ||
+            filling->entries.size() == filling->entries.capacity()) {
+            submit();
+        }
+        filling->entries.push_back({static_cast<uint32_t>(filling->bytes.size()),
+                                    static_cast<uint32_t>(length), count});
+        filling->bytes.insert(filling->bytes.end(), word, word + length);
+    }
+    
+    // Flush the last chunk and wait for every run to be written
+    bool finish() {
+        if (!filling->entries.empty()) {
+            submit();
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            closing = true;
+        }
+        ready.notify_all();
+        for (auto& sorter : sorters) {
+            sorter.join();
+        }
+        return !failed;
+    }
+    
+    std::vector<std::string> files;
+    
+private:
+    std::unique_ptr<SpillChunk> newChunk() {
+        auto chunk = std::make_unique<SpillChunk>();
+        // 3/4 for word bytes, 1/4 for entries; reserved up front so a chunk
+        // never reallocates past its share of the budget
+        chunk->bytes.reserve(std::max<size_t>(chunkBytes / 4 * 3, 4096));
+        chunk->entries.reserve(std::max<size_t>(chunkBytes / 4 / sizeof(SpillChunk::Entry), 256));
+        return chunk;
+    }
+    
+    // Hand the filling chunk to the sorters, waiting while one is queued
+    void submit() {
+        std::unique_lock<std::mutex> lock(mutex);
+        space.wait(lock, [&] { return queued == nullptr; });
+        queued = std::move(filling);
+        lock.unlock();
+        ready.notify_one();
+        filling = newChunk();
+    }
+    
+    void sorterLoop() {
+        while (true) {
+            std::unique_ptr<SpillChunk> chunk;
+            int run = 0;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                ready.wait(lock, [&] { return queued != nullptr || closing; });
+                if (queued == nullptr) {
+                    return;
+                }
+                chunk = std::move(queued);
+                run = nextRun++;
+            }
+            space.notify_one();
+            
+            std::string path = prefix + ".run" + std::to_string(run);
+            bool written = sortAndWrite(*chunk, path);
+            std::lock_guard<std::mutex> lock(mutex);
+            files.push_back(path);
+            failed = failed || !written;
+        }
+    }
+    
+    bool sortAndWrite(SpillChunk& chunk, const std::string& path) const {
+        auto& entries = chunk.entries;
+        std::sort(entries.begin(), entries.end(), [&](const SpillChunk::Entry& a, const SpillChunk::Entry& b) {
+            if (byFrequency && a.count != b.count) {
+                return a.count > b.count;
+            }
+            return chunk.word(a) < chunk.word(b);
+        });
+        if (!byFrequency) {
+            // Equal words are now adjacent: keep one, summing the counts
+            size_t kept = 0;
+            for (size_t i = 0; i < entries.size(); ++i) {
+                if (kept > 0 && chunk.word(entries[kept - 1]) == chunk.word(entries[i])) {
+                    entries[kept - 1].count += entries[i].count;
+                } else {
+                    entries[kept++] = entries[i];
+                }
+            }
+            entries.resize(kept);
+        }
+        
+        std::ofstream out(path, std::ios::binary);
+        for (const auto& entry : entries) {
+            out.write(reinterpret_cast<const char*>(&entry.length), sizeof(entry.length));
+            out.write(reinterpret_cast<const char*>(&entry.count), sizeof(entry.count));
+            out.write(chunk.bytes.data() + entry.offset, entry.length);
+        }
+        return out.good();
+    }
+    
+    std::string prefix;
+    size_t chunkBytes;
+    bool byFrequency;
+    std::vector<std::thread> sorters;
+    std::unique_ptr<SpillChunk> filling;
+    std::mutex mutex;
+    std::condition_variable ready;    // a chunk is queued, or closing
+    std::condition_variable space;    // the queue slot is free
+    std::unique_ptr<SpillChunk> queued;
+    int nextRun = 0;
+    bool closing = false;
+    bool failed = false;
+};
+
+/**
+ * K-way merge of sorted runs, calling emit(word, count) in merged order;
+ * in word order equal words from different runs are combined
+ */
+template <typename Emit>
+bool mergeRuns(const std::vector<std::string>& files, bool byFrequency, size_t bufferBytes, Emit emit) {
+    struct Reader {
+        std::ifstream in;
+        std::vector<char> buffer;
+        std::string word;
+        uint64_t count = 0;
+        
+        bool next() {
+            uint32_t length = 0;
+            if (!in.read(reinterpret_cast<char*>(&length), sizeof(length)) ||
+                !in.read(reinterpret_cast<char*>(&count), sizeof(count))) {
+                return false;
+            }
+            word.resize(length);
+            return static_cast<bool>(in.read(&word[0], length));
+        }
+    };
+    
+    std::vector<std::unique_ptr<Reader>> readers;
+    for (const auto& path : files) {
+        auto reader = std::make_unique<Reader>();
+        reader->buffer.resize(bufferBytes);
+        reader->in.rdbuf()->pubsetbuf(reader->buffer.data(), reader->buffer.size());
+        reader->in.open(path, std::ios::binary);
+        if (!reader->in.is_open()) {
+            return false;
+        }
+        readers.push_back(std::move(reader));
+    }
+    
+    // Heap top = the reader whose current record comes first
+    auto after = [&](size_t a, size_t b) {
+        const Reader& x = *readers[a];
+        const Reader& y = *readers[b];
+        if (byFrequency && x.count != y.count) {
+            return x.count < y.count;
+        }
+        return x.word > y.word;
+    };
+    std::priority_queue<size_t, std::vector<size_t>, decltype(after)> heap(after);
+    for (size_t r = 0; r < readers.size(); ++r) {
+        if (readers[r]->next()) {
+            heap.push(r);
+        }
+    }
+    
+    std::string current;
+    uint64_t currentCount = 0;
+    bool pending = false;
+    while (!heap.empty()) {
+        size_t r = heap.top();
+        heap.pop();
+        Reader& reader = *readers[r];
+        if (!byFrequency && pending && reader.word == current) {
+            currentCount += reader.count;
+        } else {
+            if (pending) {
+                emit(current, currentCount);
+            }
+            current.swap(reader.word);
+            currentCount = reader.count;
+            pending = true;
+        }
+        if (reader.next()) {
+            heap.push(r);
+        }
+    }
+    if (pending) {
+        emit(current, currentCount);
+    }
+    return true;
+}
+
+/**
+ * `dedup` subcommand: sorted, duplicate-free wordlist for --wordlist
+ * 
+ * Usage: dedup [--threads N] [--memory MB] [--by-frequency] [--temp DIR] -o OUT IN...
+ */
+int runWordlistDedup(int argc, char* argv[]) {
+    int threads = 0;
+    size_t memoryMb = 1024;
+    bool byFrequency = false;
+    std::string tempDir;
+    std::string outputPath;
+    std::vector<std::string> inputs;
+    for (int i = 2; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--threads" && i + 1 < argc) {
+            threads = std::max(1, std::stoi(argv[++i]));
+        } else if (arg == "--memory" && i + 1 < argc) {
+            memoryMb = std::max(16, std::stoi(argv[++i]));
+        } else if (arg == "--by-frequency") {
+            byFrequency = true;
+        } else if (arg == "--temp" && i + 1 < argc) {
+            tempDir = argv[++i];
+        } else if (arg == "-o" && i + 1 < argc) {
+            outputPath = argv[++i];
+        } else {
+            inputs.push_back(arg);
+        }
+    }
+    if (outputPath.empty() || inputs.empty()) {
+        std::cerr << "Usage: " << argv[0] << " dedup [--threads N] [--memory MB] [--by-frequency]"
+                  << " [--temp DIR] -o OUT IN...\n";
+        return 1;
+    }
+    if (threads == 0) {
+        threads = detectCpuBudget(false).threads;
+    }
+    
+    // Spill files go next to the output unless --temp says otherwise
+    std::string base = outputPath.substr(outputPath.rfind('/') + 1);
+    std::string prefix = tempDir.empty() ? outputPath + ".tmp" : tempDir + "/" + base + ".tmp";
+    
+    // Budget: one chunk per sorter, one queued and one filling; the
+    // chunk size also stays below what 32-bit offsets can address
+    size_t budget = memoryMb << 20;
+    size_t chunkBytes = std::min<size_t>(budget / (threads + 2), size_t(1) << 31);
+    
+    auto phaseStart = std::chrono::steady_clock::now();
+    auto lap = [&] {
+        auto now = std::chrono::steady_clock::now();
+        double seconds = std::chrono::duration<double>(now - phaseStart).count();
+        phaseStart = now;
+        return seconds;
+    };
+    auto removeAll = [](const std::vector<std::string>& files) {
+        for (const auto& file : files) {
+            std::remove(file.c_str());
+        }
+    };
+    
+    // Phase 1: chunk, sort and dedup in parallel, spill
+    long long lines = 0;
+    long long inputBytes = 0;
+    SpillRuns words(prefix + "1", threads, chunkBytes, false);
+    for (const auto& input : inputs) {
+        bool readable = forEachWord(input, [&](const char* word, size_t length) {
+            lines++;
+            inputBytes += length + 1;
+            words.add(word, length, 1);
+            return true;
+        });
+        if (!readable) {
+            std::cerr << "Error: cannot read " << input << "\n";
+            words.finish();
+            removeAll(words.files);
+            return 1;
+        }
+    }
+    if (!words.finish()) {
+        std::cerr << "Error: could not write spill files under " << prefix << "\n";
+        removeAll(words.files);
+        return 1;
+    }
+    double sortSeconds = lap();
+    
+    std::ofstream out(outputPath, std::ios::binary);
+    std::vector<char> outBuffer(1 << 20);
+    out.rdbuf()->pubsetbuf(outBuffer.data(), outBuffer.size());
+    if (!out.is_open()) {
+        std::cerr << "Error: cannot write " << outputPath << "\n";
+        removeAll(words.files);
+        return 1;
+    }
+    long long unique = 0;
+    auto write = [&](const std::string& word, uint64_t) {
+        out.write(word.data(), word.size());
+        out.put('\n');
+        unique++;
+    };
+    
+    // Phase 2: merge; by frequency, re-sort the merged counts first
+    size_t mergeBuffer = std::max<size_t>(4096, std::min<size_t>(1 << 20, budget / 2 / std::max<size_t>(1, words.files.size())));
+    bool merged = true;
+    size_t runs = words.files.size();
+    double frequencySeconds = 0;
+    if (byFrequency) {
+        SpillRuns counted(prefix + "2", threads, chunkBytes, true);
+        merged = mergeRuns(words.files, false, mergeBuffer, [&](const std::string& word, uint64_t count) {
+            counted.add(word.data(), word.size(), count);
+        });
+        merged = counted.finish() && merged;
+        removeAll(words.files);
+        frequencySeconds = lap();
+        mergeBuffer = std::max<size_t>(4096, std::min<size_t>(1 << 20, budget / 2 / std::max<size_t>(1, counted.files.size())));
+        merged = merged && mergeRuns(counted.files, true, mergeBuffer, write);
+        removeAll(counted.files);
+    } else {
+        merged = mergeRuns(words.files, false, mergeBuffer, write);
+        removeAll(words.files);
+    }
+    out.flush();
+    double mergeSeconds = lap();
+    if (!merged || !out.good()) {
+        std::cerr << "Error: merging runs into " << outputPath << " failed\n";
+        return 1;
+    }
+    
+    double total = sortSeconds + frequencySeconds + mergeSeconds;
+    std::cout << "Deduplicated " << inputs.size() << " wordlist" << (inputs.size() == 1 ? "" : "s")
+              << " into " << outputPath << (byFrequency ? " (most frequent first)" : " (sorted)") << "\n";
+    std::cout << "  Lines read:    " << lines << "\n";
+    std::cout << "  Unique words:  " << unique << " (" << std::fixed << std::setprecision(1)
+              << (lines > 0 ? 100.0 * (lines - unique) / lines : 0.0) << "% duplicates removed)\n";
+    std::cout << "  Sorted runs:   " << runs << " of up to " << (chunkBytes >> 20) << " MB, "
+              << threads << " sorter thread" << (threads == 1 ? "" : "s") << ", " << memoryMb
+              << " MB budget\n";
+    std::cout << std::setprecision(3);
+    std::cout << "  Chunk + sort:  " << sortSeconds << " s\n";
+    if (byFrequency) {
+        std::cout << "  Count order:   " << frequencySeconds << " s\n";
+    }
+    std::cout << "  Merge:         " << mergeSeconds << " s\n";
+    std::cout << "  Throughput:    " << std::setprecision(1)
+              << (total > 0 ? inputBytes / total / 1e6 : 0.0) << " MB/s of input\n";
+    return 0;
+}
+
+/**
+ * `compile-wordlist` subcommand: text wordlist -> compiled wordlist
+ * 
+ * Two streaming passes: the first counts words per length to lay out the
+ * buckets, the second scatters each word's bytes into its block's columns
+ * in the mmapped output. Words longer than --max-length (default 64) are
+ * dropped and counted.
+ * 
+ * Usage: compile-wordlist [--max-length N] IN -o OUT
+ */
+int runWordlistCompiler(int argc, char* argv[]) {
+    int maxWordLength = 64;
+    std::string inputPath;
+    std::string outputPath;
+    for (int i = 2; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--max-length" && i + 1 < argc) {
+            maxWordLength = std::max(1, std::min(COMPILED_MAX_LENGTH, std::stoi(argv[++i])));
+        } else if (arg == "-o" && i + 1 < argc) {
+            outputPath = argv[++i];
+        } else {
+            inputPath = arg;
+        }
+    }
+    if (inputPath.empty() || outputPath.empty()) {
+        std::cerr << "Usage: " << argv[0] << " compile-wordlist [--max-length N] IN -o OUT\n";
+        return 1;
+    }
+    auto start = std::chrono::steady_clock::now();
+    
+    // Pass 1: words per length
+    std::vector<uint64_t> counts(maxWordLength + 1, 0);
+    long long dropped = 0;
+    if (!forEachWord(inputPath, [&](const char*, size_t length) {
+            if (length > static_cast<size_t>(maxWordLength)) {
+                dropped++;
+            } else {
+                counts[length]++;
+            }
+            return true;
+        })) {
+        std::cerr << "Error: cannot read " << inputPath << "\n";
+        return 1;
+    }
+    
+    // Layout
+    std::vector<CompiledBucketEntry> table;
+    for (int length = 1; length <= maxWordLength; ++length) {
+        if (counts[length] > 0) {
+            table.push_back({static_cast<uint32_t>(length), 0, counts[length], 0});
+        }
+    }
+    uint64_t offset = sizeof(CompiledHeader) + table.size() * sizeof(CompiledBucketEntry);
+    uint64_t words = 0;
+    std::vector<uint64_t> bucketOffset(maxWordLength + 1, 0);
+    for (auto& entry : table) {
+        offset = (offset + 63) / 64 * 64;
+        entry.offset = offset;
+        bucketOffset[entry.length] = offset;
+        offset += (entry.count + COMPILED_LANES - 1) / COMPILED_LANES * COMPILED_LANES * entry.length;
+        words += entry.count;
+    }
+    if (words == 0) {
+        std::cerr << "Error: " << inputPath << " has no words of up to " << maxWordLength << " bytes\n";
+        return 1;
+    }
+    
+    int fd = open(outputPath.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0 || ftruncate(fd, static_cast<off_t>(offset)) != 0) {
+        std::cerr << "Error: cannot create " << outputPath << "\n";
+        if (fd >= 0) {
+            close(fd);
+        }
+        return 1;
+    }
+    void* mapped = mmap(nullptr, offset, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        std::cerr << "Error: cannot map " << outputPath << "\n";
+        return 1;
+    }
+    unsigned char* out = static_cast<unsigned char*>(mapped);
+    CompiledHeader header{COMPILED_MAGIC, COMPILED_VERSION, static_cast<uint32_t>(table.size()),
+                          COMPILED_LANES, words};
+    std::memcpy(out, &header, sizeof(header));
+    std::memcpy(out + sizeof(header), table.data(), table.size() * sizeof(CompiledBucketEntry));
+    
+    // Pass 2: scatter each word into its lane of its block
+    std::vector<uint64_t> placed(maxWordLength + 1, 0);
+    bool readable = forEachWord(inputPath, [&](const char* word, size_t length) {
+        if (length <= static_cast<size_t>(maxWordLength)) {
+            uint64_t index = placed[length]++;
+            unsigned char* block = out + bucketOffset[length] +
+                                   index / COMPILED_LANES * COMPILED_LANES * length;
+            size_t lane = index % COMPILED_LANES;
+            for (size_t p = 0; p < length; ++p) {
+                block[p * COMPILED_LANES + lane] = static_cast<unsigned char>(word[p]);
+            }
+        }
+        return true;
+    });
+    bool synced = msync(mapped, offset, MS_SYNC) == 0;
+    munmap(mapped, offset);
+    if (!readable || !synced || placed != counts) {
+        std::cerr << "Error: " << inputPath << " changed or could not be written while compiling\n";
+        return 1;
+    }
+    
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Compiled " << words << " words into " << table.size() << " length buckets ("
+              << outputPath << ", " << offset << " bytes)\n";
+    if (dropped > 0) {
+        std::cout << "  Dropped " << dropped << " words longer than " << maxWordLength << " bytes\n";
+    }
+    std::cout << "  Time: " << std::fixed << std::setprecision(3) << seconds << " s\n";
+    return 0;
+}
+
+/**
+ * `bench-wordlist` subcommand: text path vs compiled wordlist
+ * 
+ * Hashes every word of the same list three ways on one thread, best of
+ * three runs each: the text list through the pipeline (line scanning
+ * included), the compiled list through the pipeline (one word gathered
+ * at a time) and the compiled list 16 words per step.
+ * 
+ * Usage: bench-wordlist TEXT COMPILED
+ */
+int runWordlistBenchmark(int argc, char* argv[]) {
+    if (argc < 4) {
+        std::cerr << "Usage: " << argv[0] << " bench-wordlist TEXT COMPILED\n";
+        return 1;
+    }
+    std::string error;
+    if (!wordlist.load(argv[2], error) || !compiledWordlist.load(argv[3], error)) {
+        std::cerr << "Error: " << error << "\n";
+        return 1;
+    }
+    searchState.targetHash = 0xffffffffu;
+    threadCounters.reset(new ThreadCounter[1]);
+    
+    long long bytes = 0;
+    for (const auto& bucket : compiledWordlist.buckets) {
+        bytes += bucket.count * bucket.length;
+    }
+    
+    auto text = [&] {
+        long long attempts = 0;
+        CandidatePipeline<WordlistSource> pipeline{WordlistSource{}, {}, {}, {}};
+        pipeline.search<false>(0, 0, wordlist.total, attempts);
+        return attempts;
+    };
+    auto gathered = [&] {
+        long long attempts = 0;
+        CandidatePipeline<CompiledWordSource> pipeline{CompiledWordSource{}, {}, {}, {}};
+        pipeline.search<false>(0, 0, compiledWordlist.total, attempts);
+        return attempts;
+    };
+    auto lanes = [&] {
+        long long attempts = 0;
+        searchCompiled(0, 0, compiledWordlist.total, attempts);
+        return attempts;
+    };
+    
+    const char* names[3] = {"Text, per word:", "Compiled, per word:", "Compiled, 16 lanes:"};
+    long long expected[3] = {wordlist.total, compiledWordlist.total, compiledWordlist.total};
+    double best[3] = {1e300, 1e300, 1e300};
+    bool complete = true;
+    for (int round = 0; round < 3; ++round) {
+        for (int variant = 0; variant < 3; ++variant) {
+            auto start = std::chrono::steady_clock::now();
+            long long hashed = variant == 0 ? text() : variant == 1 ? gathered() : lanes();
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            best[variant] = std::min(best[variant], seconds);
+            complete = complete && hashed == expected[variant];
+        }
+    }
+    
+    std::cout << "Wordlist benchmark (" << wordlist.total << " text lines, " << compiledWordlist.total
+              << " compiled words, 1 thread, best of 3)\n";
+    std::cout << std::fixed;
+    for (int variant = 0; variant < 3; ++variant) {
+        std::cout << "  " << std::left << std::setw(21) << names[variant] << std::right
+                  << std::setprecision(2) << std::setw(7) << best[variant] * 1e9 / expected[variant]
+                  << " ns/word, " << std::setprecision(1) << std::setw(7)
+                  << expected[variant] / best[variant] / 1e6 << " M words/s, " << std::setw(7)
+                  << bytes / best[variant] / 1e6 << " MB/s\n";
+    }
+    std::cout << "  16 lanes vs text: " << std::setprecision(2) << best[0] / best[2] << "x\n";
+    if (!complete) {
+        std::cout << "  Warning: a run stopped early on a hash match\n";
+    }
+    return complete ? 0 : 1;
+}
+
+/**
+ * Attack planner
+ * 
+ * `plan` sizes each attack exactly, times its engine for a moment on one
+ * thread, scales by the thread count and prints the runtime. Given a
+ * sample of representative passwords (an earlier audit's cracks, say) it
+ * also counts the sample passwords each attack would generate and orders
+ * the attacks greedily by new sample hits per second, so a time budget
+ * goes to the most productive attacks first. Without a sample every
+ * attack is assumed equally likely to hit and the shortest run first.
+ * 
+ * Attack syntax:
+ *   brute:MIN-MAX          built-in charset, lengths MIN..MAX (or brute:N)
+ *   mask:MASK              e.g. mask:?u?l?l?l?l?d?d
+ *   wordlist:FILE[:RULES]  every word, once per line of a rule file
+ *   hybrid:FILE:MASK       every word followed by every mask candidate
+ */
+struct PlannedAttack {
+    std::string spec;
+    std::string engine;          // brute-force, mask, wordlist, hybrid
+    long long keySpace = 0;      // LLONG_MAX when it does not fit in 64 bits
+    double rate = 0;             // candidates per second, all threads
+    double seconds = 0;
+    std::vector<char> covers;    // per sample password: would be generated
+    bool rulesIgnored = false;   // sample hits count the plain words only
+};
+
+// Attack planner candidate sources over words held in memory
+struct WordSampleSource {
+    const std::vector<std::string>* words;
+    void generate(long long index, std::string& out) const {
+        out = (*words)[index % words->size()];
+    }
+};
+
+struct HybridSampleSource {
+    const std::vector<std::string>* words;
+    const Mask* mask;
+    long long maskSpace;
+    void generate(long long index, std::string& out) const {
+        thread_local std::string suffix;
+        out = (*words)[(index / maskSpace) % words->size()];
+        mask->decode(index % maskSpace, suffix);
+        out += suffix;
+    }
+};
+
+/**
+ * Single-thread candidates per second of generate + simpleHash, cycling
+ * over indices [first, first + count) for about a quarter of a second
+ */
+template <typename Source>
+double measureRate(const Source& source, long long first, long long count) {
+    std::string candidate;
+    uint32_t sink = 0;
+    long long done = 0;
+    double seconds = 0;
+    auto start = std::chrono::steady_clock::now();
+    while (seconds < 0.25) {
+        for (long long end = done + 65536; done < end; ++done) {
+            source.generate(first + done % count, candidate);
+            sink ^= simpleHash(candidate);
+        }
+        seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+    doNotOptimize(sink);
+    return done / seconds;
+}
+
+std::string formatDuration(double seconds) {
+    std::ostringstream out;
+    out << std::fixed;
+    if (seconds < 60) {
+        out << std::setprecision(seconds < 1 ? 3 : 1) << seconds << "s";
+    } else if (seconds < 3600) {
+        out << static_cast<long long>(seconds / 60) << "m " << std::setw(2) << std::setfill('0')
+            << static_cast<long long>(seconds) % 60 << "s";
+    } else if (seconds < 86400) {
+        out << static_cast<long long>(seconds / 3600) << "h " << std::setw(2) << std::setfill('0')
+            << static_cast<long long>(seconds / 60) % 60 << "m";
+    } else if (seconds < 86400.0 * 365 * 100) {
+        out << static_cast<long long>(seconds / 86400) << "d "
+            << static_cast<long long>(seconds / 3600) % 24 << "h";
+    } else {
+        out << std::setprecision(1) << std::scientific << seconds / (86400.0 * 365) << " years";
+    }
+    return out.str();
+}
+
+// "90", "90s", "30m", "2h" or "1d" in seconds; -1 if malformed
+double parseDuration(const std::string& text) {
+    char* end = nullptr;
+    double value = std::strtod(text.c_str(), &end);
+    if (end == text.c_str() || value < 0) {
+        return -1;
+    }
+    std::string unit(end);
+    if (unit.empty() || unit == "s") return value;
+    if (unit == "m") return value * 60;
+    if (unit == "h") return value * 3600;
+    if (unit == "d") return value * 86400;
+    return -1;
+}
+
+/**
+ * Size, time and (given a sample) score one attack
+ * 
+ * @return false with a message on stderr if the spec is malformed or a
+ *         file cannot be read
+ */
+bool planAttack(const std::string& spec, int threads, const std::vector<std::string>& sample,
+                PlannedAttack& attack) {
+    attack.spec = spec;
+    attack.covers.assign(sample.size(), 0);
+    size_t colon = spec.find(':');
+    std::string kind = spec.substr(0, colon);
+    std::string rest = colon == std::string::npos ? "" : spec.substr(colon + 1);
+    double rate = 0;
+    
+    if (kind == "brute") {
+        size_t dash = rest.find('-');
+        int minLength = std::atoi(rest.c_str());
+        int maxLength = dash == std::string::npos ? minLength : std::atoi(rest.c_str() + dash + 1);
+        if (minLength < 1 || maxLength < minLength || maxLength > MAX_TIERS) {
+            std::cerr << "Error: " << spec << ": expected brute:MIN-MAX with 1 <= MIN <= MAX <= "
+                      << MAX_TIERS << "\n";
+            return false;
+        }
+        attack.engine = "brute-force";
+        attack.keySpace = calculateKeySpace(minLength, maxLength, CHARSET.size());
+        // Time the longest length, which dominates the run (capped at
+        // what a 64-bit index can still address)
+        int timed = std::min(maxLength, 12);
+        long long tierStart = calculateKeySpace(timed - 1);
+        rate = measureRate(BruteForceSource{timed}, tierStart, calculateKeySpace(timed) - tierStart);
+        for (size_t s = 0; s < sample.size(); ++s) {
+            int length = static_cast<int>(sample[s].size());
+            attack.covers[s] = length >= minLength && length <= maxLength &&
+                sample[s].find_first_not_of(CHARSET) == std::string::npos;
+        }
+    } else if (kind == "mask") {
+        Mask mask;
+        if (!parseMask(rest, mask)) {
+            std::cerr << "Error: " << spec << ": not a valid mask\n";
+            return false;
+        }
+        attack.engine = "mask";
+        attack.keySpace = mask.keySpace();
+        rate = measureRate(MaskSource{&mask, 0}, 0, attack.keySpace);
+        for (size_t s = 0; s < sample.size(); ++s) {
+            attack.covers[s] = mask.matches(sample[s].data(), sample[s].size());
+        }
+    } else if (kind == "wordlist" || kind == "hybrid") {
+        size_t split = rest.find(':');
+        std::string path = rest.substr(0, split);
+        std::string extra = split == std::string::npos ? "" : rest.substr(split + 1);
+        bool hybrid = kind == "hybrid";
+        Mask mask;
+        if (hybrid && !parseMask(extra, mask)) {
+            std::cerr << "Error: " << spec << ": expected hybrid:FILE:MASK\n";
+            return false;
+        }
+        
+        // Sample passwords keyed by the word that would produce them
+        std::unordered_map<std::string, std::vector<size_t>> wanted;
+        for (size_t s = 0; s < sample.size(); ++s) {
+            const std::string& password = sample[s];
+            if (!hybrid) {
+                wanted[password].push_back(s);
+            } else if (password.size() > mask.positions.size()) {
+                size_t cut = password.size() - mask.positions.size();
+                if (mask.matches(password.data() + cut, mask.positions.size())) {
+                    wanted[password.substr(0, cut)].push_back(s);
+                }
+            }
+        }
+        
+        long long words = 0;
+        std::vector<std::string> head;   // the first words, for timing
+        bool readable = forEachWord(path, [&](const char* word, size_t length) {
+            words++;
+            if (head.size() < 65536) {
+                head.emplace_back(word, length);
+            }
+            if (!wanted.empty()) {
+                auto match = wanted.find(std::string(word, length));
+                if (match != wanted.end()) {
+                    for (size_t s : match->second) {
+                        attack.covers[s] = 1;
+                    }
+                }
+            }
+            return true;
+        });
+        if (!readable || words == 0) {
+            std::cerr << "Error: " << spec << ": cannot read words from " << path << "\n";
+            return false;
+        }
+        
+        if (hybrid) {
+            attack.engine = "hybrid";
+            attack.keySpace = saturatingMultiply(words, mask.keySpace());
+            rate = measureRate(HybridSampleSource{&head, &mask, mask.keySpace()}, 0,
+                               saturatingMultiply(static_cast<long long>(head.size()), mask.keySpace()));
+        } else {
+            long long rules = 1;
+            if (!extra.empty()) {
+                rules = 0;
+                bool rulesReadable = forEachWord(extra, [&](const char* line, size_t) {
+                    rules += line[0] != '#';
+                    return true;
+                });
+                if (!rulesReadable || rules == 0) {
+                    std::cerr << "Error: " << spec << ": cannot read rules from " << extra << "\n";
+                    return false;
+                }
+                attack.rulesIgnored = true;
+            }
+            attack.engine = "wordlist";
+            attack.keySpace = saturatingMultiply(words, rules);
+            
+            // Reading and splitting the file is part of the cost, so time
+            // the real text path rather than words already in memory
+            long long timedWords = 0;
+            uint32_t sink = 0;
+            auto start = std::chrono::steady_clock::now();
+            std::string candidate;
+            forEachWord(path, [&](const char* word, size_t length) {
+                candidate.assign(word, length);
+                sink ^= simpleHash(candidate);
+                return ++timedWords % 65536 != 0 ||
+                    std::chrono::steady_clock::now() - start < std::chrono::milliseconds(250);
+            });
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            rate = seconds > 0 ? timedWords / seconds : 0;
+            doNotOptimize(sink);
+            // Small lists finish before the clock means much; fall back to
+            // hashing the words from memory
+            if (seconds < 0.05) {
+                rate = measureRate(WordSampleSource{&head}, 0, static_cast<long long>(head.size()));
+            }
+        }
+    } else {
+        std::cerr << "Error: unknown attack \"" << spec
+                  << "\" (expected brute:, mask:, wordlist: or hybrid:)\n";
+        return false;
+    }
+    
+    attack.rate = rate * threads;
+    attack.seconds = static_cast<double>(attack.keySpace) / attack.rate;
+    return true;
+}
+
+/**
+ * `plan` subcommand: key spaces, estimated runtimes and a budgeted order
+ * 
+ * Usage: plan [--threads N] [--budget TIME] [--sample FILE] [--attacks FILE] ATTACK...
+ */
+int runPlanner(int argc, char* argv[]) {
+    int threads = 0;
+    double budget = -1;
+    std::string samplePath;
+    std::vector<std::string> specs;
+    for (int i = 2; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--threads" && i + 1 < argc) {
+            threads = std::max(1, std::stoi(argv[++i]));
+        } else if (arg == "--budget" && i + 1 < argc) {
+            budget = parseDuration(argv[++i]);
+            if (budget < 0) {
+                std::cerr << "Error: --budget expects a time such as 90s, 30m, 2h or 1d\n";
+                return 1;
+            }
+        } else if (arg == "--sample" && i + 1 < argc) {
+            samplePath = argv[++i];
+        } else if (arg == "--attacks" && i + 1 < argc) {
+            std::string path = argv[++i];
+            bool readable = forEachWord(path, [&](const char* line, size_t length) {
+                if (line[0] != '#') {
+                    specs.emplace_back(line, length);
+                }
+                return true;
+            });
+            if (!readable) {
+                std::cerr << "Error: cannot read " << path << "\n";
+                return 1;
+            }
+        } else {
+            specs.push_back(arg);
+        }
+    }
+    if (specs.empty()) {
+        std::cerr << "Usage: " << argv[0] << " plan [--threads N] [--budget TIME] [--sample FILE]"
+                  << " [--attacks FILE] ATTACK...\n"
+                  << "  ATTACK: brute:MIN-MAX | mask:MASK | wordlist:FILE[:RULES] | hybrid:FILE:MASK\n";
+        return 1;
+    }
+    if (threads == 0) {
+        threads = detectCpuBudget(false).threads;
+    }
+    
+    std::vector<std::string> sample;
+    if (!samplePath.empty() && !forEachWord(samplePath, [&](const char* word, size_t length) {
+            sample.emplace_back(word, length);
+            return true;
+        })) {
+        std::cerr << "Error: cannot read sample " << samplePath << "\n";
+        return 1;
+    }
+    
+    std::vector<PlannedAttack> attacks(specs.size());
+    for (size_t a = 0; a < specs.size(); ++a) {
+        if (!planAttack(specs[a], threads, sample, attacks[a])) {
+            return 1;
+        }
+    }
+    
+    // Greedy order: most new sample hits per second first, or without a
+    // sample the shortest attack first. Only attacks that still fit the
+    // budget are considered; the rest follow, unscheduled
+    std::vector<char> covered(sample.size(), 0);
+    std::vector<char> placed(attacks.size(), 0);
+    std::vector<size_t> order;
+    std::vector<long long> newHits;
+    std::vector<char> fits;
+    double elapsed = 0;
+    while (order.size() < attacks.size()) {
+        size_t best = attacks.size();
+        double bestScore = -1;
+        long long bestHits = 0;
+        bool bestFits = false;
+        for (size_t a = 0; a < attacks.size(); ++a) {
+            if (placed[a]) {
+                continue;
+            }
+            bool inBudget = budget < 0 || elapsed + attacks[a].seconds <= budget;
+            long long hits = 0;
+            for (size_t s = 0; s < sample.size(); ++s) {
+                hits += attacks[a].covers[s] && !covered[s];
+            }
+            double score = sample.empty() ? 1.0 / attacks[a].seconds : hits / attacks[a].seconds;
+            if (best == attacks.size() || (inBudget && !bestFits) ||
+                (inBudget == bestFits && (score > bestScore ||
+                 (score == bestScore && attacks[a].seconds < attacks[best].seconds)))) {
+                best = a;
+                bestScore = score;
+                bestHits = hits;
+                bestFits = inBudget;
+            }
+        }
+        placed[best] = 1;
+        order.push_back(best);
+        newHits.push_back(bestHits);
+        fits.push_back(bestFits);
+        if (bestFits) {
+            elapsed += attacks[best].seconds;
+            for (size_t s = 0; s < sample.size(); ++s) {
+                covered[s] |= attacks[best].covers[s];
+            }
+        }
+    }
+    
+    std::cout << "Attack plan (" << threads << " threads";
+    if (budget >= 0) {
+        std::cout << ", budget " << formatDuration(budget);
+    }
+    if (!sample.empty()) {
+        std::cout << ", sample of " << sample.size() << " passwords";
+    }
+    std::cout << ")\n\n";
+    std::cout << std::left << "  #  " << std::setw(34) << "Attack" << std::setw(12) << "Engine"
+              << std::right << std::setw(22) << "Key space" << std::setw(14) << "Rate/s"
+              << std::setw(14) << "Runtime";
+    if (!sample.empty()) {
+        std::cout << std::setw(10) << "New hits" << std::setw(12) << "Hits/hour";
+    }
+    std::cout << "\n";
+    
+    long long hitsInBudget = 0;
+    int attacksInBudget = 0;
+    bool anyIgnoredRules = false;
+    for (size_t k = 0; k < order.size(); ++k) {
+        const PlannedAttack& attack = attacks[order[k]];
+        if (fits[k]) {
+            hitsInBudget += newHits[k];
+            attacksInBudget++;
+        }
+        std::string spec = attack.spec.size() > 32 ? attack.spec.substr(0, 29) + "..." : attack.spec;
+        std::string keySpace = attack.keySpace == std::numeric_limits<long long>::max()
+            ? ">9.2e18" : std::to_string(attack.keySpace);
+        std::cout << std::left << "  " << std::setw(3) << (fits[k] ? std::to_string(k + 1) : "-")
+                  << std::setw(34) << spec << std::setw(12) << attack.engine << std::right
+                  << std::setw(22) << keySpace << std::setw(14) << std::fixed << std::setprecision(0)
+                  << attack.rate << std::setw(14) << formatDuration(attack.seconds);
+        if (!sample.empty() && fits[k]) {
+            std::cout << std::setw(10) << newHits[k] << std::setw(12) << std::setprecision(2)
+                      << newHits[k] * 3600.0 / attack.seconds;
+        } else if (!sample.empty()) {
+            std::cout << std::setw(10) << "-" << std::setw(12) << "-";
+        }
+        if (attack.rulesIgnored) {
+            std::cout << " *";
+            anyIgnoredRules = true;
+        }
+        std::cout << "\n";
+    }
+    
+    std::cout << "\n";
+    if (budget >= 0) {
+        std::cout << "Within budget: " << attacksInBudget << " of " << attacks.size() << " attacks, "
+                  << formatDuration(elapsed);
+        if (attacksInBudget < static_cast<int>(attacks.size())) {
+            std::cout << " (\"-\" rows do not fit)";
+        }
+        std::cout << "\n";
+    } else {
+        std::cout << "Total runtime: " << formatDuration(elapsed) << "\n";
+    }
+    if (!sample.empty()) {
+        std::cout << "Expected coverage: " << hitsInBudget << " of " << sample.size() << " sample passwords ("
+                  << std::setprecision(1) << 100.0 * hitsInBudget / sample.size() << "%)\n";
+    }
+    if (anyIgnoredRules) {
+        std::cout << "* rules are counted in the key space, but sample hits only cover the plain words\n";
+    }
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    // Configuration
+    std::string targetPassword = "test";
+    int numThreads = 0;            // 0 = pick from the CPU budget
+    int maxLength = 4;
+    int metricsPort = -1;
+    std::string metricsBind = "127.0.0.1";
+    int coordinatorPort = -1;
+    std::string coordinatorBind = "127.0.0.1";
+    std::string workerOf;
+    long long leaseSize = 4000000;
+    int leaseTimeout = 30;
+    int threadsOption = 0;
+    long long skip = 0;
+    long long limit = -1;
+    int shardIndex = 0;
+    int shardCount = 1;
+    std::string logPath = "performance_log.txt";
+    std::string sharedSegment;
+    bool shmJoin = false;
+    std::string daemonSocket;
+    bool elastic = false;
+    std::string controlPath;
+    bool loadPolicy = false;
+    bool pausable = false;
+    bool excludeSmt = false;
+    std::string resumeFrom;
+    std::string restoreFile = "cracker.restore";
+    std::string jsonPath;
+    int minLength = 1;
+    int maxLengthOption = 0;
+    bool randomOrder = false;
+    uint64_t orderSeed = 1;
+    std::string princeWordlist;
+    int princeElements = 8;
+    std::string pcfgPath;
+    bool keyboard = false;
+    std::string keyboardLayout;
+    int keyboardTurns = 2;
+    int keyboardJumps = 1;
+    bool dates = false;
+    int firstYear = 1950;
+    int lastYear = 2030;
+    std::string expandSpec;
+    int expandPositions = 8;
+    std::string maskFile;
+    std::string wordlistPath;
+    std::vector<std::string> wordlistFiles;   // several only when gzip-compressed
+    bool prefixTrie = false;
+    bool fromStdin = false;
+    
+    // Subcommands
+    if (argc >= 2 && std::string(argv[1]) == "submit") {
+        return runJobClient(argc, argv);
+    }
+    if (argc >= 2 && std::string(argv[1]) == "bench-order") {
+        return runOrderBenchmark(argc, argv);
+    }
+    if (argc >= 2 && std::string(argv[1]) == "bench-pipeline") {
+        return runPipelineBenchmark(argc, argv);
+    }
+    if (argc >= 2 && std::string(argv[1]) == "train-pcfg") {
+        return runPcfgTrainer(argc, argv);
+    }
+    if (argc >= 2 && std::string(argv[1]) == "plan") {
+        return runPlanner(argc, argv);
+    }
+    if (argc >= 2 && std::string(argv[1]) == "dedup") {
+        return runWordlistDedup(argc, argv);
+    }
+    if (argc >= 2 && std::string(argv[1]) == "compile-wordlist") {
+        return runWordlistCompiler(argc, argv);
+    }
+    if (argc >= 2 && std::string(argv[1]) == "bench-wordlist") {
+        return runWordlistBenchmark(argc, argv);
+    }
+    
+    // Parse command line arguments: "--" options anywhere, the rest positional
+    std::vector<std::string> positional;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--metrics-port" && i + 1 < argc) {
+            metricsPort = std::stoi(argv[++i]);
+        } else if (arg == "--metrics-bind" && i + 1 < argc) {
+            metricsBind = argv[++i];
+        } else if (arg == "--coordinator" && i + 1 < argc) {
+            coordinatorPort = std::stoi(argv[++i]);
+        } else if (arg == "--coordinator-bind" && i + 1 < argc) {
+            coordinatorBind = argv[++i];
+        } else if (arg == "--worker" && i + 1 < argc) {
+            workerOf = argv[++i];
+        } else if (arg == "--lease-size" && i + 1 < argc) {
+            leaseSize = std::max(1LL, std::stoll(argv[++i]));
+        } else if (arg == "--lease-timeout" && i + 1 < argc) {
+            leaseTimeout = std::max(1, std::stoi(argv[++i]));
+        } else if (arg == "--threads" && i + 1 < argc) {
+            threadsOption = std::max(1, std::stoi(argv[++i]));
+        } else if (arg == "--skip" && i + 1 < argc) {
+            skip = std::max(0LL, std::stoll(argv[++i]));
+        } else if (arg == "--limit" && i + 1 < argc) {
+            limit = std::max(0LL, std::stoll(argv[++i]));
+        } else if (arg == "--shard" && i + 1 < argc) {
+            std::string spec = argv[++i];
+            size_t slash = spec.find('/');
+            if (slash == std::string::npos) {
+                std::cerr << "Error: --shard expects i/n, e.g. 2/4\n";
+                return 1;
+            }
+            shardIndex = std::stoi(spec.substr(0, slash));
+            shardCount = std::stoi(spec.substr(slash + 1));
+            if (shardCount < 1 || shardIndex < 1 || shardIndex > shardCount) {
+                std::cerr << "Error: --shard " << spec << " is out of range (1 <= i <= n)\n";
+                return 1;
+            }
+            shardIndex--;
+        } else if (arg == "--log-file" && i + 1 < argc) {
+            logPath = argv[++i];
+        } else if ((arg == "--shm" || arg == "--shm-join") && i + 1 < argc) {
+            sharedSegment = argv[++i];
+            shmJoin = arg == "--shm-join";
+        } else if (arg == "--daemon" && i + 1 < argc) {
+            daemonSocket = argv[++i];
+        } else if (arg == "--elastic") {
+            elastic = true;
+        } else if (arg == "--control" && i + 1 < argc) {
+            controlPath = argv[++i];
+            elastic = true;
+        } else if (arg == "--load-policy") {
+            loadPolicy = true;
+            elastic = true;
+        } else if (arg == "--cpu-limit" && i + 1 < argc) {
+            throttle.cpuPercent = std::stod(argv[++i]);
+            if (throttle.cpuPercent < 1.0 || throttle.cpuPercent > 100.0) {
+                std::cerr << "Error: --cpu-limit expects a percentage between 1 and 100\n";
+                return 1;
+            }
+        } else if (arg == "--idle-priority") {
+            throttle.idlePriority = true;
+        } else if (arg == "--nice" && i + 1 < argc) {
+            throttle.niceValue = std::max(-20, std::min(19, std::stoi(argv[++i])));
+        } else if (arg == "--pausable") {
+            pausable = true;
+        } else if (arg == "--no-smt") {
+            excludeSmt = true;
+        } else if (arg == "--restore" && i + 1 < argc) {
+            resumeFrom = argv[++i];
+        } else if (arg == "--restore-file" && i + 1 < argc) {
+            restoreFile = argv[++i];
+        } else if (arg == "--json" && i + 1 < argc) {
+            jsonPath = argv[++i];
+        } else if (arg == "--random-order") {
+            randomOrder = true;
+        } else if (arg == "--seed" && i + 1 < argc) {
+            orderSeed = std::stoull(argv[++i], nullptr, 0);
+        } else if (arg == "--prince" && i + 1 < argc) {
+            princeWordlist = argv[++i];
+        } else if (arg == "--prince-elements" && i + 1 < argc) {
+            princeElements = std::max(1, std::stoi(argv[++i]));
+        } else if (arg == "--pcfg" && i + 1 < argc) {
+            pcfgPath = argv[++i];
+        } else if (arg == "--keyboard") {
+            keyboard = true;
+        } else if (arg == "--kb-layout" && i + 1 < argc) {
+            keyboardLayout = argv[++i];
+            keyboard = true;
+        } else if (arg == "--kb-turns" && i + 1 < argc) {
+            keyboardTurns = std::max(0, std::stoi(argv[++i]));
+            keyboard = true;
+        } else if (arg == "--kb-jumps" && i + 1 < argc) {
+            keyboardJumps = std::max(0, std::stoi(argv[++i]));
+            keyboard = true;
+        } else if (arg == "--expand" && i + 1 < argc) {
+            expandSpec = argv[++i];
+        } else if (arg == "--expand-positions" && i + 1 < argc) {
+            expandPositions = std::max(1, std::min(30, std::stoi(argv[++i])));
+        } else if (arg == "--policy" && i + 1 < argc) {
+            if (!parsePolicy(argv[++i], passwordPolicy)) {
+                std::cerr << "Error: --policy expects items like min=8,max=16,classes=3,upper,digit"
+                          << " (non-negative numbers, classes at most 4, min no larger than max)\n";
+                return 1;
+            }
+        } else if (arg == "--wordlist" && i + 1 < argc) {
+            wordlistPath = argv[++i];
+            wordlistFiles.push_back(wordlistPath);
+        } else if (arg == "--stdin") {
+            fromStdin = true;
+        } else if (arg == "--prefix-trie") {
+            prefixTrie = true;
+        } else if (arg == "--masks" && i + 1 < argc) {
+            maskFile = argv[++i];
+        } else if (arg == "--dates") {
+            dates = true;
+        } else if (arg == "--date-years" && i + 1 < argc) {
+            std::string spec = argv[++i];
+            size_t dash = spec.find('-');
+            std::string first = spec.substr(0, dash);
+            std::string last = dash == std::string::npos ? first : spec.substr(dash + 1);
+            auto year = [](const std::string& text) {
+                bool digits = !text.empty() && text.size() <= 4 &&
+                              std::all_of(text.begin(), text.end(),
+                                          [](unsigned char c) { return std::isdigit(c); });
+                return digits ? std::stoi(text) : -1;
+            };
+            firstYear = year(first);
+            lastYear = year(last);
+            if (firstYear < 0 || lastYear < 0 || firstYear > lastYear) {
+                std::cerr << "Error: --date-years expects a range like 1950-2030\n";
+                return 1;
+            }
+            dates = true;
+        } else if (arg == "--min-length" && i + 1 < argc) {
+            minLength = std::max(1, std::stoi(argv[++i]));
+        } else if (arg == "--max-length" && i + 1 < argc) {
+            maxLengthOption = std::stoi(argv[++i]);
+        } else if (arg.rfind("--", 0) == 0) {
+            std::cerr << "Error: unknown or incomplete option " << arg << "\n";
+            return 1;
+        } else {
+            positional.push_back(arg);
+        }
+    }
+    
+    if (positional.size() >= 1) {
+        targetPassword = positional[0];
+    }
+    if (positional.size() >= 2 && positional[1] != "auto") {
+        numThreads = std::stoi(positional[1]);
+        if (numThreads < 1) numThreads = 1;
+    }
+    if (positional.size() >= 3 && maxLengthOption == 0) {
+        maxLengthOption = std::stoi(positional[2]);
+    }
+    int sourceOptions = !princeWordlist.empty() + !pcfgPath.empty() + keyboard + dates + !maskFile.empty() +
+                        !wordlistPath.empty() + fromStdin;
+    bool structured = sourceOptions > 0;
+    if (sourceOptions > 1) {
+        std::cerr << "Error: choose one of --prince, --pcfg, --keyboard, --dates, --masks, --wordlist and --stdin\n";
+        return 1;
+    }
+    if (maxLengthOption != 0) {
+        maxLength = maxLengthOption;
+        if (maxLength < 1) maxLength = 1;
+        if (!structured && maxLength > 8) {
+            std::cout << "Warning: maxLength > 8 may take very long. Limiting to 8.\n";
+            maxLength = 8;
+        }
+        if (maxLength > MAX_TIERS) {
+            std::cout << "Warning: chains longer than " << MAX_TIERS << " are not supported. Limiting to "
+                      << MAX_TIERS << ".\n";
+            maxLength = MAX_TIERS;
+        }
+    } else if (!princeWordlist.empty()) {
+        maxLength = 12;   // passphrase-length default for chains
+    } else if (keyboard || dates) {
+        maxLength = 10;   // "1qaz2wsx3e", "1984-05-12"
+    }
+    if (threadsOption > 0) {
+        numThreads = threadsOption;
+    }
+    
+    std::string threadSource = "explicit";
+    if (numThreads == 0) {
+        CpuBudget budget = detectCpuBudget(excludeSmt);
+        numThreads = budget.threads;
+        std::ostringstream source;
+        source << "auto: " << budget.affinityCpus << " CPUs in affinity mask";
+        if (excludeSmt) {
+            source << ", " << budget.physicalCores << " physical cores";
+        }
+        if (budget.quotaCpus > 0) {
+            source << ", cgroup quota " << std::fixed << std::setprecision(2)
+                   << budget.quotaCpus << " CPUs";
+        }
+        threadSource = source.str();
+    }
+    
+    // Chunked, throttle-aware worker loops only when something needs them
+    throttle.enabled = throttle.cpuPercent < 100.0 || pausable || !controlPath.empty();
+    if (pausable) {
+        signal(SIGUSR2, handlePauseSignal);
+    }
+    
+    // Restrict the searched index range: length range first, then the shard
+    // of that, then --skip/--limit relative to the start of the shard
+    bool compiled = !wordlistPath.empty() && CompiledWordlist::isCompiled(wordlistPath);
+    bool streamed = fromStdin || (!wordlistPath.empty() && isGzipFile(wordlistPath));
+    for (const auto& path : wordlistFiles) {
+        if (wordlistFiles.size() > 1 && !isGzipFile(path)) {
+            std::cerr << "Error: --wordlist can be given more than once only for gzip-compressed lists ("
+                      << path << " is not)\n";
+            return 1;
+        }
+    }
+    if (minLength > maxLength && maskFile.empty() && wordlistPath.empty() && !fromStdin) {
+        std::cerr << "Error: --min-length " << minLength << " exceeds maximum length "
+                  << maxLength << "\n";
+        return 1;
+    }
+    
+    // PRINCE chains replace the brute-force key space with the chain space
+    if (!princeWordlist.empty()) {
+        std::string error;
+        if (!princeChains.load(princeWordlist, maxLength, princeElements, error)) {
+            std::cerr << "Error: --prince: " << error << "\n";
+            return 1;
+        }
+        candidateSource = CandidateSource::Prince;
+    }
+    if (keyboard) {
+        std::vector<std::string> rows = QWERTY_ROWS;
+        if (!keyboardLayout.empty()) {
+            std::ifstream layout(keyboardLayout);
+            if (!layout.is_open()) {
+                std::cerr << "Error: --kb-layout: could not open " << keyboardLayout << "\n";
+                return 1;
+            }
+            rows.clear();
+            for (std::string row; std::getline(layout, row);) {
+                rows.push_back(row);
+            }
+        }
+        std::string error;
+        if (!keyboardWalks.setup(rows, maxLength, keyboardTurns, keyboardJumps, error)) {
+            std::cerr << "Error: --keyboard: " << error << "\n";
+            return 1;
+        }
+        candidateSource = CandidateSource::Keyboard;
+    }
+    if (dates) {
+        datePatterns.setup(firstYear, lastYear, maxLength);
+        candidateSource = CandidateSource::Dates;
+    }
+    
+    // A mask queue is worked through in file order from a shared cursor
+    bool masks = !maskFile.empty();
+    if (masks) {
+        std::string error;
+        if (!maskQueue.load(maskFile, error)) {
+            std::cerr << "Error: --masks: " << error << "\n";
+            return 1;
+        }
+        if (randomOrder || elastic || minLength > 1) {
+            std::cout << "Note: --masks runs masks in file order; ignoring --random-order, --elastic"
+                      << " and --min-length (use --policy min=N)\n";
+            randomOrder = false;
+            elastic = false;
+            minLength = 1;
+        }
+        maxLength = maskQueue.longest;
+        candidateSource = CandidateSource::Masks;
+    }
+    if (streamed) {
+        // Streamed words arrive in no fixed order and cannot be indexed
+        if (shardCount > 1 || skip > 0 || limit >= 0 || randomOrder || elastic || !resumeFrom.empty() ||
+            !expandSpec.empty() || prefixTrie || minLength > 1) {
+            std::cout << "Note: " << (fromStdin ? "--stdin candidates" : "compressed wordlists")
+                      << " are streamed; ignoring --shard, --skip, --limit, "
+                         "--random-order, --elastic, --restore, --expand, --prefix-trie and --min-length\n";
+            shardIndex = 0;
+            shardCount = 1;
+            skip = 0;
+            limit = -1;
+            randomOrder = false;
+            elastic = false;
+            resumeFrom.clear();
+            expandSpec.clear();
+            prefixTrie = false;
+            minLength = 1;
+        }
+        candidateSource = fromStdin ? CandidateSource::Stdin : CandidateSource::Stream;
+    } else if (compiled) {
+        // Length buckets make lengths usable: --max-length/--min-length pick buckets
+        std::string error;
+        if (!compiledWordlist.load(wordlistPath, error)) {
+            std::cerr << "Error: --wordlist: " << error << "\n";
+            return 1;
+        }
+        maxLength = maxLengthOption > 0 ? std::min(maxLengthOption, compiledWordlist.longest)
+                                        : compiledWordlist.longest;
+        if (minLength > maxLength) {
+            std::cerr << "Error: --min-length " << minLength << " exceeds the longest word ("
+                      << maxLength << ")\n";
+            return 1;
+        }
+        candidateSource = CandidateSource::Compiled;
+    } else if (!wordlistPath.empty()) {
+        std::string error;
+        if (!wordlist.load(wordlistPath, error)) {
+            std::cerr << "Error: --wordlist: " << error << "\n";
+            return 1;
+        }
+        if (minLength > 1) {
+            std::cout << "Note: --wordlist keeps file order; ignoring --min-length (use --policy min=N)\n";
+            minLength = 1;
+        }
+        maxLength = std::max(1, wordlist.longest);
+        candidateSource = CandidateSource::Wordlist;
+        if (prefixTrie && (!expandSpec.empty() || passwordPolicy.enabled || randomOrder)) {
+            std::cout << "Note: --prefix-trie walks plain words in file order; ignoring it with "
+                         "--expand, --policy or --random-order\n";
+        } else {
+            prefixSharing.enabled = prefixTrie;
+        }
+    }
+    if (prefixTrie && candidateSource != CandidateSource::Wordlist) {
+        std::cout << "Note: --prefix-trie applies to text --wordlist runs only\n";
+    }
+    
+    // PCFG runs keep only structures in the length range and hand out
+    // guesses in probability order; --limit caps the number of guesses
+    PcfgModel pcfgModel;
+    if (!pcfgPath.empty()) {
+        if (!pcfgModel.load(pcfgPath)) {
+            std::cerr << "Error: --pcfg: could not read model " << pcfgPath << "\n";
+            return 1;
+        }
+        int longest = maxLengthOption != 0 ? maxLength : std::numeric_limits<int>::max();
+        pcfgModel.structures.erase(
+            std::remove_if(pcfgModel.structures.begin(), pcfgModel.structures.end(),
+                           [&](const PcfgStructure& structure) {
+                               return structure.length < minLength || structure.length > longest;
+                           }),
+            pcfgModel.structures.end());
+        if (shardCount > 1 || skip > 0 || randomOrder || elastic || !resumeFrom.empty()) {
+            std::cout << "Note: --pcfg ignores --shard, --skip, --random-order, --elastic and --restore\n";
+            randomOrder = false;
+            elastic = false;
+            resumeFrom.clear();
+        }
+        candidateSource = CandidateSource::Pcfg;
+    }
+    
+    // Shorter tiers are skipped whole: the first index of length minLength
+    // is the cumulative size of all shorter tiers
+    bool pcfg = candidateSource == CandidateSource::Pcfg;
+    
+    // Case/leet variants multiply every index source by a fixed stride
+    if (!expandSpec.empty()) {
+        bool cases = expandSpec.find("case") != std::string::npos;
+        bool substitutions = expandSpec.find("leet") != std::string::npos;
+        if (!cases && !substitutions) {
+            std::cerr << "Error: --expand expects case, leet or case,leet\n";
+            return 1;
+        }
+        if (pcfg) {
+            std::cout << "Note: --expand does not apply to --pcfg\n";
+        } else {
+            caseLeet.setup(cases, substitutions, expandPositions, maxLength);
+            if (sourceBaseSize(maxLength) > std::numeric_limits<long long>::max() / caseLeet.stride) {
+                std::cerr << "Error: expanded space exceeds a 64-bit index; lower --expand-positions\n";
+                return 1;
+            }
+        }
+    }
+    searchState.fullKeySpace = pcfg ? pcfgModel.guessCount() : sourceSpaceSize(maxLength);
+    long long lengthStart = pcfg ? 0 : sourceLengthStart(minLength);
+    if (pcfg) {
+        shardCount = 1;
+        skip = 0;
+    }
+    auto shard = shardBounds(searchState.fullKeySpace - lengthStart, shardIndex, shardCount);
+    shard.first += lengthStart;
+    shard.second += lengthStart;
+    searchState.rangeStart = std::min(shard.second, shard.first + skip);
+    searchState.rangeEnd = shard.second;
+    if (limit >= 0) {
+        searchState.rangeEnd = std::min(searchState.rangeEnd, searchState.rangeStart + limit);
+    }
+    searchState.keySpaceSize = searchState.rangeEnd - searchState.rangeStart;
+    if (shardCount > 1) {
+        searchState.shardLabel = std::to_string(shardIndex + 1) + "/" + std::to_string(shardCount);
+    }
+    
+    // Distributed modes take over before the local search is set up
+    bool distributed = !workerOf.empty() || coordinatorPort >= 0 || !daemonSocket.empty() ||
+                       !sharedSegment.empty();
+    if (randomOrder && distributed) {
+        std::cout << "Note: --random-order only applies to local searches; using sequential order\n";
+    }
+    if (structured && distributed) {
+        std::cerr << "Error: --prince, --pcfg, --keyboard, --dates, --masks, --wordlist and --stdin only apply to"
+                  << " local searches\n";
+        return 1;
+    }
+    // Other processes only learn the target and maximum length, so they
+    // would search expanded indices as plain brute force
+    if (caseLeet.enabled && distributed) {
+        std::cerr << "Error: --expand only applies to local searches\n";
+        return 1;
+    }
+    if (!workerOf.empty()) {
+        return runRemoteWorker(workerOf, numThreads);
+    }
+    if (coordinatorPort >= 0) {
+        searchState.targetHash = simpleHash(targetPassword);
+        MetricsServer coordinatorMetrics;
+        if (metricsPort >= 0 && !coordinatorMetrics.start(metricsBind, metricsPort)) {
+            std::cerr << "Warning: could not start metrics endpoint on "
+                      << metricsBind << ":" << metricsPort << "\n";
+        }
+        return runCoordinator(coordinatorBind, coordinatorPort, maxLength, leaseSize, leaseTimeout);
+    }
+    if (!daemonSocket.empty()) {
+        return runJobDaemon(daemonSocket, numThreads);
+    }
+    if (!sharedSegment.empty()) {
+        searchState.targetHash = simpleHash(targetPassword);
+        return runSharedMemoryMode(sharedSegment, shmJoin, numThreads, maxLength, leaseSize, logPath, jsonPath);
+    }
+    
+    // Calculate target hash
+    searchState.targetHash = simpleHash(targetPassword);
+    
+    // Positions in the length-restricted space map through the permutation
+    if (randomOrder) {
+        enumerationOrder.setup(lengthStart, searchState.fullKeySpace - lengthStart, orderSeed);
+    }
+    
+    // Resuming replaces the range computed above with the pending ranges
+    std::vector<std::pair<long long, long long>> pending;
+    if (!resumeFrom.empty()) {
+        if (!readRestorePoint(resumeFrom, searchState.targetHash, maxLength, pending)) {
+            std::cerr << "Error: could not read restore point " << resumeFrom << "\n";
+            return 1;
+        }
+        searchState.fullKeySpace = sourceSpaceSize(maxLength);
+        searchState.keySpaceSize = 0;
+        for (const auto& range : pending) {
+            searchState.keySpaceSize += range.second - range.first;
+        }
+        if (elastic) {
+            std::cout << "Note: --elastic is not supported when resuming; using a static split\n";
+            elastic = false;
+        }
+    }
+    
+    // Tier accounting needs positions to be key-space indices
+    if (!enumerationOrder.permuted && !pcfg) {
+        initSourceTierStats(maxLength);
+    }
+    
+    std::cout << "═══════════════════════════════════════════════════\n";
+    std::cout << "  MULTITHREADED PASSWORD CRACKER\n";
+    std::cout << "═══════════════════════════════════════════════════\n";
+    std::cout << "Target Password: \"" << targetPassword << "\"\n";
+    std::cout << "Target Hash: " << searchState.targetHash
+              << (resumeFrom.empty() ? "" : " (from restore point)") << "\n";
+    std::cout << "Number of Threads: " << numThreads << " (" << threadSource << ")\n";
+    if (minLength > 1) {
+        std::cout << "Password Lengths: " << minLength << " to " << maxLength << "\n";
+    } else if (!streamed) {
+        std::cout << "Maximum Password Length: " << maxLength << "\n";
+    }
+    if (pcfg) {
+        std::cout << "Candidates: PCFG model " << pcfgPath << " (" << pcfgModel.structures.size()
+                  << " structures), most probable first\n";
+    } else if (candidateSource == CandidateSource::Prince) {
+        std::cout << "Candidates: PRINCE chains of up to " << princeChains.maxElements
+                  << " elements from " << princeChains.wordlist << " ("
+                  << princeChains.elementCount << " elements)\n";
+    } else if (candidateSource == CandidateSource::Keyboard) {
+        std::cout << "Candidates: keyboard walks over " << keyboardWalks.keys.size() << " keys ("
+                  << (keyboardLayout.empty() ? "QWERTY" : keyboardLayout) << "), up to "
+                  << keyboardTurns << " turns and " << keyboardJumps << " jumps\n";
+    } else if (candidateSource == CandidateSource::Dates) {
+        std::cout << "Candidates: dates from " << firstYear << " to " << lastYear << " in "
+                  << datePatterns.blocks.size() << " formats\n";
+    } else if (masks) {
+        std::cout << "Candidates: " << maskQueue.masks.size() << " masks from " << maskFile
+                  << ", in file order\n";
+    } else if (candidateSource == CandidateSource::Wordlist) {
+        std::cout << "Candidates: " << wordlist.total << " words from " << wordlistPath
+                  << (prefixSharing.enabled ? " (prefix-sharing walk)" : "") << "\n";
+    } else if (fromStdin) {
+        std::cout << "Candidates: every line of standard input\n";
+    } else if (streamed) {
+        std::cout << "Candidates: every line of " << wordlistFiles.size() << " gzip-compressed wordlist"
+                  << (wordlistFiles.size() == 1 ? "" : "s") << ", streamed\n";
+    } else if (compiled) {
+        std::cout << "Candidates: " << compiledWordlist.total << " words from " << wordlistPath
+                  << " (compiled, " << compiledWordlist.buckets.size() << " length buckets"
+                  << (!caseLeet.enabled && !passwordPolicy.enabled && !enumerationOrder.permuted
+                      ? ", hashed " + std::to_string(COMPILED_LANES) + " words per step" : "")
+                  << ")\n";
+    } else {
+        std::cout << "Character Set: " << CHARSET << " (" << CHARSET.length() 
+                  << " characters)\n";
+    }
+    if (enumerationOrder.permuted) {
+        std::cout << "Enumeration Order: keyed random permutation (seed "
+                  << enumerationOrder.seed << ")\n";
+    }
+    if (caseLeet.enabled) {
+        std::cout << "Expansion: " << (caseLeet.toggleCase ? "case" : "")
+                  << (caseLeet.toggleCase && caseLeet.leet ? " + " : "") << (caseLeet.leet ? "leet" : "")
+                  << " variants of the first " << caseLeet.maxPositions << " mutable characters ("
+                  << caseLeet.stride << " slots per word)\n";
+    }
+    if (passwordPolicy.enabled) {
+        std::cout << "Policy Filter: length " << passwordPolicy.minLength << "-";
+        if (passwordPolicy.maxLength > 0) {
+            std::cout << passwordPolicy.maxLength;
+        } else {
+            std::cout << "any";
+        }
+        std::cout << (passwordPolicy.required & CLASS_LOWER ? ", lower" : "")
+                  << (passwordPolicy.required & CLASS_UPPER ? ", upper" : "")
+                  << (passwordPolicy.required & CLASS_DIGIT ? ", digit" : "")
+                  << (passwordPolicy.required & CLASS_SPECIAL ? ", special" : "");
+        if (passwordPolicy.minClasses > 0) {
+            std::cout << ", " << passwordPolicy.minClasses << "+ classes";
+        }
+        std::cout << "\n";
+    }
+    std::cout << "═══════════════════════════════════════════════════\n\n";
+    
+    // Calculate key space size
+    long long keySpaceSize = searchState.keySpaceSize;
+    
+    if (streamed) {
+        std::cout << "Key Space Size: unknown until the stream ends\n";
+    } else {
+        std::cout << "Key Space Size: " << searchState.fullKeySpace << " possible passwords\n";
+    }
+    if (streamed) {
+        std::cout << (fromStdin ? "  (Every line until end of input)\n" : "  (Every line of every file)\n");
+    } else if (pcfg) {
+        std::cout << "  (All guesses of the structures in range)\n";
+    } else if (masks) {
+        std::cout << "  (All candidates of every mask)\n";
+    } else if (candidateSource == CandidateSource::Wordlist) {
+        std::cout << "  (Every line of the wordlist)\n";
+    } else if (compiled) {
+        std::cout << "  (Every word of length " << minLength << " to " << maxLength << ")\n";
+    } else {
+        std::cout << "  (All " << (structured ? "candidates" : "passwords") << " from length 1 to "
+                  << maxLength << ")\n";
+    }
+    if (!resumeFrom.empty()) {
+        std::cout << "Resuming " << pending.size() << " pending ranges from " << resumeFrom
+                  << " (" << keySpaceSize << " passwords)\n";
+    } else if (keySpaceSize != searchState.fullKeySpace) {
+        std::cout << "Searching indices " << searchState.rangeStart << " to "
+                  << searchState.rangeEnd << " (" << keySpaceSize << " passwords";
+        if (!searchState.shardLabel.empty()) {
+            std::cout << ", shard " << searchState.shardLabel;
+        }
+        std::cout << ")\n";
+    }
+    std::cout << "\n";
+    
+    // Partition key space among threads: a restore point's pending ranges,
+    // or an even share of every length tier
+    auto assignments = resumeFrom.empty()
+        ? partitionByTier(searchState.rangeStart, searchState.rangeEnd, numThreads)
+        : splitRanges(pending, numThreads);
+    if (prefixSharing.enabled && resumeFrom.empty()) {
+        alignToSubtrees(assignments);
+    }
+    
+    std::cout << "Key Space Partitioning:\n";
+    if (elastic) {
+        std::cout << "  Dynamic chunks of " << leaseSize << " indices, starting with "
+                  << numThreads << " threads (SIGTTIN/SIGTTOU add/retire a thread)\n";
+    } else if (pcfg) {
+        std::cout << "  Batches of up to " << PcfgDispenser::BATCH
+                  << " guesses from a shared probability-ordered queue\n";
+    } else if (masks) {
+        std::cout << "  Chunks of " << QUEUE_CHUNK << " indices from a shared cursor, mask by mask, "
+                  << numThreads << " threads\n";
+    } else if (fromStdin) {
+        std::cout << "  Batches of about " << (STDIN_BATCH_SIZE >> 10) << " KB cut from "
+                  << 2 * numThreads + 2 << " blocks of " << (STDIN_BLOCK_SIZE >> 20)
+                  << " MB, 1 reader, " << numThreads << " hashing threads on a lock-free queue\n";
+    } else if (streamed) {
+        std::cout << "  " << wordlistFiles.size() << " decompression thread"
+                  << (wordlistFiles.size() == 1 ? "" : "s") << " filling a ring of "
+                  << 2 * (wordlistFiles.size() + numThreads) << " buffers of "
+                  << (STREAM_BUFFER_SIZE >> 20) << " MB, " << numThreads << " hashing threads\n";
+    }
+    for (int i = 0; i < numThreads && !elastic && !pcfg && !masks && !streamed; ++i) {
+        long long share = 0;
+        for (const auto& range : assignments[i]) {
+            share += range.second - range.first;
+        }
+        std::cout << "  Thread " << i << ": ";
+        if (assignments[i].size() == 1) {
+            std::cout << "indices " << assignments[i][0].first << " to " << assignments[i][0].second;
+        } else {
+            std::cout << assignments[i].size() << " ranges";
+        }
+        std::cout << " (" << share << " passwords)\n";
+    }
+    std::cout << "\n";
+    
+    searchState.startTime = std::chrono::steady_clock::now();
+    
+    threadCounters.reset(new ThreadCounter[elastic ? ELASTIC_MAX_THREADS : numThreads]);
+    threadCounterCount = elastic ? 0 : numThreads;
+    
+    // Must happen before any helper or worker thread exists
+    SignalSupervisor::blockSignals();
+    SignalSupervisor signalSupervisor;
+    signalSupervisor.start();
+    
+    MetricsServer metricsServer;
+    if (metricsPort >= 0) {
+        if (metricsServer.start(metricsBind, metricsPort)) {
+            std::cout << "Metrics endpoint: http://" << metricsBind << ":" << metricsPort
+                      << "/metrics\n\n";
+        } else {
+            std::cerr << "Warning: could not start metrics endpoint on "
+                      << metricsBind << ":" << metricsPort << "\n";
+        }
+    }
+    
+    // Start worker threads
+    std::vector<std::thread> threads;
+    long long pcfgPreterminals = 0;
+    if (pcfg) {
+        pcfgPreterminals = runPcfgSearch(pcfgModel, numThreads, searchState.keySpaceSize);
+    } else if (fromStdin) {
+        runStdinSearch(numThreads);
+    } else if (streamed) {
+        runStreamSearch(wordlistFiles, numThreads);
+    } else if (elastic) {
+        runElasticSearch(numThreads, maxLength, leaseSize, controlPath, loadPolicy);
+    }
+    RangeCursor queueCursor;
+    if (masks) {
+        queueCursor.ranges = resumeFrom.empty()
+            ? std::vector<std::pair<long long, long long>>{{searchState.rangeStart, searchState.rangeEnd}}
+            : pending;
+        std::sort(queueCursor.ranges.begin(), queueCursor.ranges.end());
+        for (int i = 0; i < numThreads; ++i) {
+            threads.emplace_back(queueWorker, i, std::ref(queueCursor), maxLength);
+        }
+    }
+    for (int i = 0; i < numThreads && !elastic && !pcfg && !masks && !streamed; ++i) {
+        threads.emplace_back(crackerWorker, i, assignments[i], maxLength);
+    }
+    
+    // Wait for all threads to complete
+    for (auto& t : threads) {
+        if (t.joinable()) {
+            t.join();
+        }
+    }
+    if (masks && searchState.interrupted.load()) {
+        queueCursor.recordRemaining();
+    }
+    
+    signalSupervisor.stop();
+    metricsServer.stop();
+    
+    bool restoreWritten = false;
+    if (searchState.interrupted.load() && !searchState.passwordFound.load() && !pcfg && !streamed) {
+        restoreWritten = writeRestorePoint(restoreFile, maxLength);
+        if (!restoreWritten) {
+            std::cerr << "Warning: could not write restore point " << restoreFile << "\n";
+        }
+    }
+    
+    auto endTime = std::chrono::steady_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+        endTime - searchState.startTime).count();
+    
+    // Display results
+    std::cout << "\n═══════════════════════════════════════════════════\n";
+    std::cout << "  RESULTS\n";
+    std::cout << "═══════════════════════════════════════════════════\n";
+    
+    if (searchState.passwordFound.load()) {
+        std::cout << "✓ Password FOUND: \"" << searchState.foundPassword << "\"\n";
+        std::cout << "  Expected: \"" << targetPassword << "\"\n";
+        
+        if (searchState.foundPassword == targetPassword) {
+            std::cout << "  Status: EXACT MATCH ✓\n";
+        } else {
+            std::cout << "  Status: Hash collision (different password, same hash)\n";
+        }
+    } else if (searchState.interrupted.load()) {
+        std::cout << "⏸ Search INTERRUPTED before the key space was exhausted\n";
+        if (restoreWritten) {
+            std::cout << "  Resume with: --restore " << restoreFile << "\n";
+        }
+    } else {
+        std::cout << "✗ Password NOT FOUND in searched key space\n";
+        if (streamed) {
+            std::cout << (fromStdin ? "  (Not a line of the input)\n" : "  (Not a line of the streamed wordlists)\n");
+        } else if (searchState.keySpaceSize != searchState.fullKeySpace) {
+            std::cout << "  (Only indices " << searchState.rangeStart << " to "
+                      << searchState.rangeEnd << " were searched)\n";
+        } else {
+            std::cout << "  (Password may be longer than maxLength=" << maxLength << ")\n";
+        }
+    }
+    
+    std::cout << "\nPerformance Summary:\n";
+    std::cout << "  Total Attempts: " << searchState.totalAttempts.load() << "\n";
+    if (caseLeet.enabled || passwordPolicy.enabled) {
+        long long filtered = searchState.filteredCandidates.load();
+        std::cout << "  Hashed: " << (searchState.totalAttempts.load() - searchState.skippedCandidates.load())
+                  << " (";
+        if (caseLeet.enabled) {
+            std::cout << (searchState.skippedCandidates.load() - filtered) << " empty variant slots skipped"
+                      << (passwordPolicy.enabled ? ", " : "");
+        }
+        if (passwordPolicy.enabled) {
+            std::cout << filtered << " rejected by policy";
+        }
+        std::cout << ")\n";
+    }
+    if (prefixSharing.enabled && searchState.totalAttempts.load() > 0) {
+        double words = static_cast<double>(searchState.totalAttempts.load());
+        long long wordBytes = prefixSharing.wordBytes.load();
+        std::cout << "  Bytes Hashed per Word: " << std::fixed << std::setprecision(2)
+                  << prefixSharing.hashedBytes.load() / words << " of " << wordBytes / words
+                  << " (" << std::setprecision(1)
+                  << (wordBytes > 0 ? 100.0 - 100.0 * prefixSharing.hashedBytes.load() / wordBytes : 0.0)
+                  << "% reused from shared prefixes)\n";
+    }
+    if (pcfg) {
+        std::cout << "  Pre-terminals Expanded: " << pcfgPreterminals << "\n";
+    }
+    if (fromStdin) {
+        const StdinStats& input = stdinStats;
+        std::cout << "  Stdin: " << std::fixed << std::setprecision(1) << input.bytes.load() / 1e6
+                  << " MB in " << input.batches.load() << " batches ("
+                  << (input.seconds > 0 ? input.bytes.load() / 1e6 / input.seconds : 0.0) << " MB/s)\n";
+        std::cout << "    Reader:  " << std::setprecision(0) << 100 * input.share(input.readNanos.load(), 1)
+                  << "% in poll/read, " << 100 * input.share(input.readerBlockedNanos.load(), 1)
+                  << "% blocked on busy workers\n";
+        std::cout << "    Workers: " << input.workers << " thread" << (input.workers == 1 ? "" : "s") << ", "
+                  << 100 * input.share(input.starvedNanos.load(), input.workers)
+                  << "% starved on an empty queue (" << input.emptyPolls.load() << " empty polls)\n";
+        std::cout << "    Bottleneck: " << input.bottleneck() << "\n";
+        if (!input.error.empty()) {
+            std::cout << "  Warning: input stopped early: " << input.error << "\n";
+        }
+    } else if (streamed) {
+        const StreamStats& stream = streamStats;
+        std::cout << "  Stream: " << std::fixed << std::setprecision(1) << stream.compressedBytes / 1e6
+                  << " MB compressed -> " << stream.bytes.load() / 1e6 << " MB of words ("
+                  << (stream.seconds > 0 ? stream.bytes.load() / 1e6 / stream.seconds : 0.0) << " MB/s)\n";
+        std::cout << "    Decompression: " << stream.producers << " thread"
+                  << (stream.producers == 1 ? "" : "s") << ", " << std::setprecision(0)
+                  << 100 * stream.share(stream.producerBusyNanos.load(), stream.producers) << "% busy, "
+                  << 100 * stream.share(stream.producerBlockedNanos, stream.producers)
+                  << "% blocked on a full ring\n";
+        std::cout << "    Hashing:       " << stream.workers << " thread" << (stream.workers == 1 ? "" : "s")
+                  << ", " << 100 * stream.share(stream.workerBusyNanos.load(), stream.workers) << "% busy, "
+                  << 100 * stream.share(stream.workerStarvedNanos, stream.workers)
+                  << "% starved waiting for data\n";
+        std::cout << "    Bottleneck: " << stream.bottleneck() << "\n";
+        if (!stream.error.empty()) {
+            std::cout << "  Warning: stream stopped early: " << stream.error << "\n";
+        }
+    }
+    if (masks) {
+        std::cout << "  Mask Queue:\n";
+        for (size_t k = 0; k < maskQueue.masks.size(); ++k) {
+            const MaskCounter& counter = maskQueue.counters[k];
+            long long size = (maskQueue.start[k + 1] - maskQueue.start[k]) * caseLeet.stride;
+            double wall = counter.firstNanos.load() < 0 ? 0.0
+                : (counter.lastNanos.load() - counter.firstNanos.load()) / 1e9;
+            std::cout << "    " << std::setw(3) << (k + 1) << ". " << std::left << std::setw(24)
+                      << maskQueue.masks[k].text << std::right << std::setw(16)
+                      << counter.candidates.load() << " / " << std::left << std::setw(16) << size
+                      << std::right << std::fixed << std::setprecision(3) << std::setw(10) << wall
+                      << "s  " << counter.hits.load() << " hit" << (counter.hits.load() == 1 ? "" : "s")
+                      << "\n";
+        }
+    }
+    std::cout << "  Total Time: " << std::fixed << std::setprecision(3) 
+              << (duration / 1000.0) << " seconds\n";
+    
+    if (duration > 0 && searchState.skippedCandidates.load() > 0) {
+        std::cout << "  Throughput: " << std::fixed << std::setprecision(2)
+                  << (searchState.hashedCandidates() * 1000.0 / duration)
+                  << " hashed candidates/sec\n";
+    } else if (duration > 0) {
+        std::cout << "  Throughput: " << std::fixed << std::setprecision(2)
+                  << (searchState.totalAttempts.load() * 1000.0 / duration) 
+                  << " attempts/sec\n";
+    }
+    
+    // Log performance metrics
+    logPerformanceMetrics(logPath);
     
-    std::cout << "\nDetailed metrics saved to: performance_log.txt\n";
+    std::cout << "\nDetailed metrics saved to: " << logPath << "\n";
+    if (!jsonPath.empty()) {
+        writeJsonReport(jsonPath);
+        std::cout << "JSON report saved to: " << jsonPath << "\n";
+    }
     std::cout << "═══════════════════════════════════════════════════\n";
     
     return 0;